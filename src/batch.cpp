@@ -0,0 +1,208 @@
+#include "batch.h"
+#include "sudoku_lockstep.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    enum class Result { Pending, Solved, Unsolvable, TimedOut, Invalid };
+
+    // A puzzle in the window of puzzles being solved
+    template <int N>
+    struct Slot {
+        BasicSudoku<N> sudoku;
+        Result result = Result::Pending;
+        int numSolutions = 0;
+        chrono::nanoseconds solveTime{0};
+    };
+}
+
+template <int N>
+BatchStats solveBatch(BasicPuzzleSource<N> &reader, ostream &out, ostream &err
+                      , const BasicSudokuSolver<N> &solver, ThreadPool &pool
+                      , int countLimit, const SolveLimits &limits) {
+
+    // Solvers may keep state between puzzles, so every worker gets its own
+    vector<unique_ptr<BasicSudokuSolver<N>>> solvers;
+    for (int i=0; i<pool.getNumThreads(); ++i) {
+        solvers.push_back(solver.clone());
+    }
+
+    // Puzzles are handed to the workers in groups of LANES, which are
+    // first all filled in by singles at once, see BasicLockstepSolver, and
+    // only the puzzles left are solved by solver.
+    constexpr size_t LANES = BasicLockstepSolver<N>::LANES;
+    vector<BasicLockstepSolver<N>> locksteps(pool.getNumThreads());
+
+    // Enough puzzles in flight that every worker stays busy while the
+    // oldest puzzle is still being solved.
+    const size_t window = max<size_t>(1024, 256 * pool.getNumThreads());
+    vector<Slot<N>> slots(window);
+
+    // Guards the results of slots. Signalled when a puzzle is solved.
+    mutex doneMutex;
+    condition_variable done;
+
+    BatchStats stats;
+    string buffer;
+    bool endOfInput = false;
+
+    // Puzzles head to tail - 1 are in the window. Slot i holds puzzle
+    // number i modulo window. Puzzles from group to tail - 1 aren't handed
+    // to a worker yet.
+    size_t head = 0;
+    size_t tail = 0;
+    size_t group = 0;
+
+    // Solves the puzzles from group to tail - 1 on a worker. The puzzles
+    // that could be read are picked here, since the worker must only look
+    // at the slots it owns: the slot of an invalid puzzle may be reused
+    // for a later puzzle before the worker runs.
+    auto submitGroup = [&] {
+        array<Slot<N>*, LANES> pending;
+        int count = 0;
+        for (size_t i = group; i < tail; ++i) {
+            Slot<N> &slot = slots[i % window];
+            if (slot.result == Result::Pending) pending[count++] = &slot;
+        }
+        group = tail;
+        if (count == 0) return;
+
+        pool.submit([&, pending, count] {
+            BasicSudokuSolver<N> &solver = *solvers[pool.getWorkerIndex()];
+            BasicLockstepSolver<N> &lockstep = locksteps[pool.getWorkerIndex()];
+
+            // Fill in the singles of every puzzle of the group at once
+            auto start = chrono::steady_clock::now();
+            array<BasicSudoku<N>*, LANES> boards;
+            for (int i=0; i<count; ++i) boards[i] = &pending[i]->sudoku;
+            uint32_t filled = lockstep.solve(boards.data(), count);
+            auto time = (chrono::steady_clock::now() - start) / count;
+
+            {
+                lock_guard<mutex> lock(doneMutex);
+                for (int i=0; i<count; ++i) {
+                    if ((filled >> i & 1) == 0) continue;
+                    pending[i]->solveTime = time;
+                    pending[i]->numSolutions = 1;
+                    pending[i]->result = Result::Solved;
+                }
+                done.notify_one();
+            }
+
+            for (int i=0; i<count; ++i) {
+                if ((filled >> i & 1) != 0) continue;
+                Slot<N> &slot = *pending[i];
+
+                start = chrono::steady_clock::now();
+                int numSolutions = 0;
+                SolveResult solved;
+                if (countLimit > 0) {
+                    CountResult counted = solver.countWithin(slot.sudoku, countLimit
+                                                             , limits.start());
+                    numSolutions = counted.count;
+                    solved = counted.result;
+                } else if (limits.isUnlimited()) {
+                    solved = solver.solve(slot.sudoku) ? SolveResult::Solved
+                                                       : SolveResult::Unsolvable;
+                } else {
+                    solved = solver.solveWithin(slot.sudoku, limits.start());
+                }
+                Result result = solved == SolveResult::Solved ? Result::Solved
+                                : solved == SolveResult::Unsolvable ? Result::Unsolvable
+                                : Result::TimedOut;
+                auto solveTime = time + (chrono::steady_clock::now() - start);
+
+                // Notify while holding the lock, since the condition
+                // variable is gone once the last result is written.
+                lock_guard<mutex> lock(doneMutex);
+                slot.solveTime = solveTime;
+                slot.numSolutions = numSolutions;
+                slot.result = result;
+                done.notify_one();
+            }
+        });
+    };
+
+    while (true) {
+        // Fill the window with new puzzles
+        while (!endOfInput && tail - head < window) {
+            Slot<N> &slot = slots[tail % window];
+            slot.sudoku = BasicSudoku<N>();
+            slot.result = Result::Pending;
+
+            try {
+                if (!reader.next(slot.sudoku)) {
+                    endOfInput = true;
+                    break;
+                }
+            } catch (exception &e) {
+                err << e.what() << endl;
+                slot.result = Result::Invalid;
+            }
+            ++tail;
+            if (tail - group == LANES) submitGroup();
+        }
+
+        // Hand off a partial group at the end of the input, or if the
+        // oldest puzzle is in it
+        if (head == tail) break;
+        if (group != tail && (endOfInput || head >= group)) submitGroup();
+
+        // Wait for the oldest puzzle and write its result
+        Slot<N> &slot = slots[head % window];
+        {
+            unique_lock<mutex> lock(doneMutex);
+            done.wait(lock, [&slot] { return slot.result != Result::Pending; });
+        }
+        ++head;
+
+        ++stats.numPuzzles;
+        stats.solveTime += slot.solveTime;
+
+        if (slot.result == Result::Solved) ++stats.numSolved;
+
+        if (countLimit > 0 && (slot.result == Result::Solved
+                               || slot.result == Result::Unsolvable)) {
+            buffer += to_string(slot.numSolutions);
+            buffer.push_back('\n');
+        } else if (slot.result == Result::Solved) {
+            appendLine(buffer, slot.sudoku);
+            buffer.push_back('\n');
+        } else if (slot.result == Result::Unsolvable) {
+            buffer += "unsolvable\n";
+        } else if (slot.result == Result::TimedOut) {
+            buffer += "timeout\n";
+            ++stats.numTimedOut;
+        } else {
+            buffer += "invalid\n";
+            ++stats.numInvalid;
+        }
+
+        // Write output in large blocks instead of once per puzzle
+        if (buffer.size() >= (1 << 16)) {
+            out.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    }
+
+    out.write(buffer.data(), buffer.size());
+    out.flush();
+
+    return stats;
+}
+
+template BatchStats solveBatch(BasicPuzzleSource<3>&, ostream&, ostream&
+                               , const BasicSudokuSolver<3>&, ThreadPool&, int
+                               , const SolveLimits&);
+template BatchStats solveBatch(BasicPuzzleSource<4>&, ostream&, ostream&
+                               , const BasicSudokuSolver<4>&, ThreadPool&, int
+                               , const SolveLimits&);
+template BatchStats solveBatch(BasicPuzzleSource<5>&, ostream&, ostream&
+                               , const BasicSudokuSolver<5>&, ThreadPool&, int
+                               , const SolveLimits&);
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include "sudoku_io.h"
+#include "sudoku_solver.h"
+#include "thread_pool.h"
+
+// BatchStats summarizes the puzzles solved by solveBatch.
+struct BatchStats {
+    int numPuzzles = 0;
+    // Number of puzzles with at least one solution
+    int numSolved = 0;
+    int numInvalid = 0;
+    // Number of puzzles that ran out of time or nodes
+    int numTimedOut = 0;
+
+    // Total time spent solving, summed over all workers.
+    std::chrono::nanoseconds solveTime{0};
+};
+
+// Solves every puzzle read by reader on the workers of pool, and writes one
+// line per puzzle to out, in input order: the solution as one line, see
+// appendLine,
+// "unsolvable" if there is no solution, or "invalid" if the puzzle couldn't
+// be read. Errors reading puzzles are printed to err.
+// If countLimit > 0, counts the solutions of each puzzle instead, up to
+// countLimit, and writes the number found, or "invalid". Gives up on
+// puzzles that reach limits, and writes "timeout" for them.
+// Puzzles are solved in a sliding window, so a slow puzzle only holds back
+// the output while the workers keep solving the puzzles after it. Workers
+// take the puzzles in groups, fill in the singles of a whole group at once
+// with BasicLockstepSolver, and solve the puzzles left with their own clone
+// of solver.
+// effects: reads from reader
+//          writes to out and err
+template <int N>
+BatchStats solveBatch(BasicPuzzleSource<N> &reader, std::ostream &out
+                      , std::ostream &err, const BasicSudokuSolver<N> &solver
+                      , ThreadPool &pool, int countLimit = 0
+                      , const SolveLimits &limits = SolveLimits());
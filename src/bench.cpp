@@ -0,0 +1,521 @@
+// sudoku-bench times every engine and heuristic over the example puzzles and
+// larger corpora, and reports puzzles per second and solve latencies. Each
+// puzzle is solved on a single thread, so the numbers are comparable between
+// engines and with earlier runs, except for the portfolio, which races
+// several engines on a thread each. If search stats are enabled, also reports
+// the work done by the search. Collecting them slows the search down, so
+// the timings aren't comparable with a build without stats.
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <filesystem>
+#include <exception>
+#include <cstdlib>
+#include <cstring>
+#include "sudoku_io.h"
+#include "sudoku_backtrack.h"
+#include "sudoku_dlx.h"
+#include "sudoku_sat.h"
+#include "sudoku_portfolio.h"
+
+#ifndef SUDOKU_EXAMPLES_DIR
+#define SUDOKU_EXAMPLES_DIR "examples"
+#endif
+
+using namespace std;
+namespace fs = std::filesystem;
+using Clock = chrono::steady_clock;
+
+// Whether the puzzles of a corpus are expected to have a solution.
+enum class Expect {solvable, unsolvable, mixed};
+
+// A named set of puzzles to time.
+struct Corpus {
+    string name;
+    vector<Sudoku> puzzles;
+    Expect expect;
+
+    // Configs with a lower strength than this are skipped unless --all is
+    // given, because they take minutes or more on some of the puzzles.
+    int minStrength;
+};
+
+// A named engine and its settings.
+struct Config {
+    string name;
+    unique_ptr<SudokuSolver> solver;
+
+    // Rough ranking of how well the config copes with hard puzzles, see
+    // Corpus::minStrength.
+    int strength;
+};
+
+// Timings of one config over one corpus.
+struct Result {
+    string config;
+    string corpus;
+    bool skipped = false;
+
+    int numPuzzles = 0;
+    int numSolved = 0;
+
+    // Puzzles whose result didn't match what the corpus expects, or whose
+    // solution is wrong.
+    int numWrong = 0;
+
+    // Number of passes over the corpus, and the total number of solves.
+    int numPasses = 0;
+    long numRuns = 0;
+
+    double totalSeconds = 0;
+    double puzzlesPerSecond = 0;
+
+    // Solve latencies in microseconds.
+    double p50 = 0;
+    double p99 = 0;
+    double max = 0;
+
+    // Search stats summed over the first pass, and nodes searched per
+    // second over every pass. Zero unless stats are enabled.
+    SearchStats stats;
+    double nodesPerSecond = 0;
+};
+
+// Prints command line usage
+void usage(const char *name) {
+    cerr << "Usage: " << name << " [options]" << endl;
+    cerr << "Options:" << endl;
+    cerr << "  --examples dir   Read the puzzles from dir (default " << SUDOKU_EXAMPLES_DIR << ")" << endl;
+    cerr << "  --min-time s     Repeat each corpus for at least s seconds per" << endl;
+    cerr << "                   config (default 0.5)" << endl;
+    cerr << "  --generated n    Number of generated puzzles (default 1000)" << endl;
+    cerr << "  --seed n         Seed of the generated puzzles (default 1)" << endl;
+    cerr << "  --config name    Only run the named config. Can be repeated" << endl;
+    cerr << "  --corpus name    Only run the named corpus. Can be repeated" << endl;
+    cerr << "  --all            Also run the configs that are very slow on a corpus" << endl;
+    cerr << "  --json file      Write the results to file as JSON" << endl;
+    cerr << "  --scalar         Don't use the vectorized board scans" << endl;
+}
+
+// Returns the configs to benchmark.
+vector<Config> makeConfigs() {
+    vector<Config> configs;
+
+    auto addBacktrack = [&](const string &name, int heuristic, int inference
+                            , int strength, int backjumping = 0) {
+        auto backtrack = make_unique<SudokuBacktrack>();
+        backtrack->setHeuristic(heuristic);
+        backtrack->setInference(inference);
+        backtrack->setBackjumping(backjumping);
+        configs.push_back(Config{name, move(backtrack), strength});
+    };
+    addBacktrack("h1", 1, 0, 0);
+    addBacktrack("h2", 2, 0, 1);
+    addBacktrack("h3", 3, 0, 2);
+    addBacktrack("h3-i1", 3, 1, 3);
+    addBacktrack("h3-i2", 3, 2, 4);
+    addBacktrack("h3-b1", 3, 0, 2, 1);
+    addBacktrack("h3-b2", 3, 0, 2, 2);
+    configs.push_back(Config{"dlx", make_unique<SudokuDLX>(), 4});
+    configs.push_back(Config{"sat", make_unique<SudokuSAT>(), 4});
+    configs.push_back(Config{"portfolio", makeDefaultPortfolio<3>(), 4});
+
+    return configs;
+}
+
+// Appends every puzzle in the stream to puzzles. Throws runtime_error if a
+// puzzle is malformed.
+// effects: puzzles may change
+void readPuzzles(istream &in, const string &source, vector<Sudoku> &puzzles) {
+    PuzzleReader reader(in);
+    while (true) {
+        Sudoku board;
+        try {
+            if (!reader.next(board)) break;
+        } catch (const exception &e) {
+            throw runtime_error(source + ": " + e.what());
+        }
+        puzzles.push_back(board);
+    }
+}
+
+// Returns the puzzles in path, a file or a directory of .txt files read in
+// name order. Throws runtime_error if path can't be read.
+vector<Sudoku> loadPuzzles(const fs::path &path) {
+    vector<fs::path> files;
+    if (fs::is_directory(path)) {
+        for (const auto &entry : fs::directory_iterator(path)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".txt") {
+                files.push_back(entry.path());
+            }
+        }
+        sort(files.begin(), files.end());
+    } else {
+        files.push_back(path);
+    }
+
+    vector<Sudoku> puzzles;
+    for (const auto &file : files) {
+        ifstream in(file);
+        if (!in.is_open()) {
+            throw runtime_error("File " + file.string() + " not found.");
+        }
+        readPuzzles(in, file.string(), puzzles);
+    }
+    if (puzzles.empty()) {
+        throw runtime_error("No puzzles in " + path.string());
+    }
+    return puzzles;
+}
+
+// Returns a random integer in [0, n) from rng. Unlike the standard
+// distributions, the sequence is the same with every standard library, so
+// the generated corpus is the same everywhere.
+int randomInt(mt19937 &rng, int n) {
+    return static_cast<int>(rng() % static_cast<unsigned>(n));
+}
+
+// Shuffles values with rng, see randomInt.
+// effects: values may change
+template <typename T, size_t N>
+void shuffle(array<T, N> &values, mt19937 &rng) {
+    for (int i = static_cast<int>(N) - 1; i > 0; --i) {
+        swap(values[i], values[randomInt(rng, i + 1)]);
+    }
+}
+
+// Returns numPuzzles random puzzles with numClues clues each, generated from
+// seed. Each puzzle is made by solving a board with a shuffled first row,
+// shuffling the rows and columns within bands and stacks, the bands, the
+// stacks and the digits of the solution, and keeping numClues random cells.
+// The puzzles always have a solution, but often more than one.
+vector<Sudoku> generatePuzzles(int numPuzzles, int numClues, unsigned seed) {
+    mt19937 rng(seed);
+    SudokuDLX dlx;
+    vector<Sudoku> puzzles;
+
+    for (int n=0; n<numPuzzles; ++n) {
+        array<int, 9> digits = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+        shuffle(digits, rng);
+
+        Sudoku grid;
+        for (int x=0; x<9; ++x) {
+            grid.initCell(x, 0, digits[x]);
+        }
+        dlx.solve(grid);
+
+        // Maps every row and column of the puzzle to one of grid
+        array<int, 9> rows;
+        array<int, 9> cols;
+        for (auto *order : {&rows, &cols}) {
+            array<int, 3> bands = {0, 1, 2};
+            shuffle(bands, rng);
+            for (int b=0; b<3; ++b) {
+                array<int, 3> lines = {0, 1, 2};
+                shuffle(lines, rng);
+                for (int i=0; i<3; ++i) {
+                    (*order)[b*3 + i] = bands[b]*3 + lines[i];
+                }
+            }
+        }
+        shuffle(digits, rng);
+
+        array<int, 81> cells;
+        for (int i=0; i<81; ++i) cells[i] = i;
+        shuffle(cells, rng);
+
+        Sudoku puzzle;
+        for (int i=0; i<numClues; ++i) {
+            int x = cells[i] % 9;
+            int y = cells[i] / 9;
+            puzzle.initCell(x, y, digits[grid.getCell(cols[x], rows[y]) - 1]);
+        }
+        puzzles.push_back(puzzle);
+    }
+
+    return puzzles;
+}
+
+// Returns the latency at percentile p of the sorted latencies, using the
+// nearest rank.
+// requires: latencies is sorted and not empty
+//           0 < p <= 1
+double percentile(const vector<double> &latencies, double p) {
+    size_t rank = static_cast<size_t>(p * latencies.size() + 0.999999);
+    return latencies[max<size_t>(rank, 1) - 1];
+}
+
+// Solves every puzzle of corpus with solver, repeating the corpus until
+// minSeconds have passed, and returns the timings.
+// effects: solver may change
+Result run(SudokuSolver &solver, const Corpus &corpus, double minSeconds) {
+    Result result;
+    result.corpus = corpus.name;
+    result.numPuzzles = static_cast<int>(corpus.puzzles.size());
+
+    vector<double> latencies;
+    Clock::duration total{0};
+    long totalNodes = 0;
+
+    do {
+        for (const Sudoku &puzzle : corpus.puzzles) {
+            Sudoku board = puzzle;
+
+            auto start = Clock::now();
+            bool solved = solver.solve(board);
+            auto finish = Clock::now();
+
+            total += finish - start;
+            latencies.push_back(chrono::duration<double, micro>(finish - start).count());
+
+            SearchStats stats = solver.getStats();
+            totalNodes += stats.nodes;
+
+            bool wrong = (solved && !board.isSolved())
+                         || (solved && corpus.expect == Expect::unsolvable)
+                         || (!solved && corpus.expect == Expect::solvable);
+
+            // Results are the same on every pass, so only count the first
+            if (result.numPasses == 0) {
+                if (solved) ++result.numSolved;
+                if (wrong) ++result.numWrong;
+                result.stats += stats;
+            }
+        }
+        ++result.numPasses;
+    } while (chrono::duration<double>(total).count() < minSeconds);
+
+    sort(latencies.begin(), latencies.end());
+    result.numRuns = static_cast<long>(latencies.size());
+    result.totalSeconds = chrono::duration<double>(total).count();
+    result.puzzlesPerSecond = result.numRuns / result.totalSeconds;
+    result.nodesPerSecond = totalNodes / result.totalSeconds;
+    result.p50 = percentile(latencies, 0.50);
+    result.p99 = percentile(latencies, 0.99);
+    result.max = latencies.back();
+
+    return result;
+}
+
+// Prints one row of the results table.
+void printRow(const Result &result) {
+    char line[160];
+    if (result.skipped) {
+        snprintf(line, sizeof(line), "%-9s %-12s %7d  skipped, use --all to run"
+                 , result.config.c_str(), result.corpus.c_str(), result.numPuzzles);
+    } else {
+        snprintf(line, sizeof(line), "%-9s %-12s %7d %7d %6d %12.1f %10.1f %10.1f %10.1f"
+                 , result.config.c_str(), result.corpus.c_str(), result.numPuzzles
+                 , result.numSolved, result.numWrong, result.puzzlesPerSecond
+                 , result.p50, result.p99, result.max);
+    }
+    cout << line;
+
+    // Engines that don't collect stats search no nodes
+    if (STATS_ENABLED && !result.skipped
+        && (result.stats.nodes > 0 || result.stats.valuesPropagated > 0)) {
+        const SearchStats &stats = result.stats;
+        snprintf(line, sizeof(line), " %12.0f %10ld %10ld %6d %10ld %10ld %8.1f %8.1f"
+                 , result.nodesPerSecond, stats.nodes, stats.backtracks, stats.maxDepth
+                 , stats.valuesPruned, stats.valuesPropagated
+                 , chrono::duration<double, milli>(stats.varOrderingTime).count()
+                 , chrono::duration<double, milli>(stats.valueOrderingTime).count());
+        cout << line;
+    }
+    cout << endl;
+}
+
+// Writes the results to out as JSON.
+// effects: writes to out
+void writeJson(ostream &out, const vector<Result> &results, double minSeconds
+               , int numGenerated, unsigned seed) {
+    out << "{\n";
+    out << "  \"minTime\": " << minSeconds << ",\n";
+    out << "  \"generated\": " << numGenerated << ",\n";
+    out << "  \"seed\": " << seed << ",\n";
+    out << "  \"stats\": " << (STATS_ENABLED ? "true" : "false") << ",\n";
+    out << "  \"results\": [";
+    for (size_t i=0; i<results.size(); ++i) {
+        const Result &r = results[i];
+        out << (i == 0 ? "\n" : ",\n");
+        out << "    {\"config\": \"" << r.config << "\", \"corpus\": \"" << r.corpus
+            << "\", \"puzzles\": " << r.numPuzzles;
+        if (r.skipped) {
+            out << ", \"skipped\": true}";
+            continue;
+        }
+        out << ", \"solved\": " << r.numSolved << ", \"wrong\": " << r.numWrong
+            << ", \"passes\": " << r.numPasses << ", \"runs\": " << r.numRuns
+            << ", \"seconds\": " << r.totalSeconds
+            << ", \"puzzlesPerSecond\": " << r.puzzlesPerSecond
+            << ", \"p50Us\": " << r.p50 << ", \"p99Us\": " << r.p99
+            << ", \"maxUs\": " << r.max;
+        if (STATS_ENABLED) {
+            out << ", \"nodesPerSecond\": " << r.nodesPerSecond
+                << ", \"nodes\": " << r.stats.nodes
+                << ", \"backtracks\": " << r.stats.backtracks
+                << ", \"maxDepth\": " << r.stats.maxDepth
+                << ", \"valuesPruned\": " << r.stats.valuesPruned
+                << ", \"valuesPropagated\": " << r.stats.valuesPropagated
+                << ", \"varOrderingMs\": "
+                << chrono::duration<double, milli>(r.stats.varOrderingTime).count()
+                << ", \"valueOrderingMs\": "
+                << chrono::duration<double, milli>(r.stats.valueOrderingTime).count();
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+// Returns true if names is empty or contains name.
+bool isSelected(const vector<string> &names, const string &name) {
+    return names.empty() || find(names.begin(), names.end(), name) != names.end();
+}
+
+int main(int argc, char *argv[])
+{
+    fs::path examplesDir = SUDOKU_EXAMPLES_DIR;
+    double minSeconds = 0.5;
+    int numGenerated = 1000;
+    unsigned seed = 1;
+    vector<string> configNames;
+    vector<string> corpusNames;
+    bool all = false;
+    const char *jsonFile = nullptr;
+
+    // Parse command line options
+    for (int i=1; i<argc; ++i) {
+        char *end = nullptr;
+        if (strcmp(argv[i], "--examples") == 0 && i+1 < argc) {
+            examplesDir = argv[++i];
+        } else if (strcmp(argv[i], "--min-time") == 0 && i+1 < argc) {
+            minSeconds = strtod(argv[++i], &end);
+            if (*end != '\0' || minSeconds < 0) {
+                cerr << "Minimum time " << argv[i] << " is not a number of seconds" << endl;
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--generated") == 0 && i+1 < argc) {
+            numGenerated = static_cast<int>(strtol(argv[++i], &end, 10));
+            if (*end != '\0' || numGenerated < 0) {
+                cerr << "Puzzle count " << argv[i] << " is not a number" << endl;
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--seed") == 0 && i+1 < argc) {
+            seed = static_cast<unsigned>(strtoul(argv[++i], &end, 10));
+            if (*end != '\0') {
+                cerr << "Seed " << argv[i] << " is not a number" << endl;
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--config") == 0 && i+1 < argc) {
+            configNames.push_back(argv[++i]);
+        } else if (strcmp(argv[i], "--corpus") == 0 && i+1 < argc) {
+            corpusNames.push_back(argv[++i]);
+        } else if (strcmp(argv[i], "--all") == 0) {
+            all = true;
+        } else if (strcmp(argv[i], "--json") == 0 && i+1 < argc) {
+            jsonFile = argv[++i];
+        } else if (strcmp(argv[i], "--scalar") == 0) {
+            simd::setEnabled(false);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    vector<Config> configs = makeConfigs();
+    vector<Corpus> corpora;
+    try {
+        corpora.push_back(Corpus{"solvable", loadPuzzles(examplesDir / "solvable")
+                                 , Expect::solvable, 0});
+        corpora.push_back(Corpus{"edge-cases", loadPuzzles(examplesDir / "edge-cases")
+                                 , Expect::mixed, 2});
+        corpora.push_back(Corpus{"easy", loadPuzzles(examplesDir / "corpora" / "easy.txt")
+                                 , Expect::solvable, 0});
+        if (numGenerated > 0) {
+            corpora.push_back(Corpus{"generated", generatePuzzles(numGenerated, 30, seed)
+                                     , Expect::solvable, 0});
+        }
+        corpora.push_back(Corpus{"hard", loadPuzzles(examplesDir / "corpora" / "hard.txt")
+                                 , Expect::solvable, 0});
+        corpora.push_back(Corpus{"unsolvable", loadPuzzles(examplesDir / "corpora" / "unsolvable.txt")
+                                 , Expect::unsolvable, 4});
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 2;
+    }
+
+    for (const string &name : configNames) {
+        if (none_of(configs.begin(), configs.end()
+                    , [&](const Config &c) {return c.name == name;})) {
+            cerr << "Config " << name << " doesn't exist" << endl;
+            return 2;
+        }
+    }
+    for (const string &name : corpusNames) {
+        if (none_of(corpora.begin(), corpora.end()
+                    , [&](const Corpus &c) {return c.name == name;})) {
+            cerr << "Corpus " << name << " doesn't exist" << endl;
+            return 2;
+        }
+    }
+
+    cout << "Board scans: " << (simd::enabled() ? "AVX2" : "scalar") << endl;
+
+    char header[160];
+    snprintf(header, sizeof(header), "%-9s %-12s %7s %7s %6s %12s %10s %10s %10s"
+             , "config", "corpus", "puzzles", "solved", "wrong", "puzzles/s"
+             , "p50 us", "p99 us", "max us");
+    cout << header;
+    if (STATS_ENABLED) {
+        snprintf(header, sizeof(header), " %12s %10s %10s %6s %10s %10s %8s %8s"
+                 , "nodes/s", "nodes", "backtracks", "depth", "pruned", "propagated"
+                 , "var ms", "value ms");
+        cout << header;
+    }
+    cout << endl;
+
+    vector<Result> results;
+    int numWrong = 0;
+    for (Config &config : configs) {
+        if (!isSelected(configNames, config.name)) continue;
+
+        for (const Corpus &corpus : corpora) {
+            if (!isSelected(corpusNames, corpus.name)) continue;
+
+            Result result;
+            if (all || config.strength >= corpus.minStrength) {
+                result = run(*config.solver, corpus, minSeconds);
+            } else {
+                result.corpus = corpus.name;
+                result.numPuzzles = static_cast<int>(corpus.puzzles.size());
+                result.skipped = true;
+            }
+            result.config = config.name;
+            numWrong += result.numWrong;
+
+            printRow(result);
+            results.push_back(result);
+        }
+    }
+
+    if (jsonFile != nullptr) {
+        ofstream out(jsonFile);
+        if (!out.is_open()) {
+            cerr << "File " << jsonFile << " can't be written." << endl;
+            return 2;
+        }
+        writeJson(out, results, minSeconds, numGenerated, seed);
+    }
+
+    if (numWrong > 0) {
+        cerr << numWrong << " puzzles had a wrong result" << endl;
+        return 1;
+    }
+    return 0;
+}
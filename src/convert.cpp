@@ -0,0 +1,225 @@
+// sudoku-convert converts puzzles between the text formats read by batch
+// mode and the packed binary format, see sudoku_binary.h. The direction is
+// picked from the input: binary files are written as text, one puzzle per
+// line, and text files are written as binary. Batch output, with a
+// solution, "unsolvable", "timeout" or "invalid" per line, can be converted
+// as a file of solutions, where the puzzles without a solution become empty
+// records.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <exception>
+#include <cstdlib>
+#include <cstring>
+#include "sudoku_binary.h"
+
+using namespace std;
+
+// Prints command line usage
+void usage(const char *name) {
+    cerr << "Usage: " << name << " [options] input output" << endl;
+    cerr << "Converts a binary file to text, or a text file to binary. The text" << endl;
+    cerr << "is read from stdin if input is -, and written to stdout if output is -" << endl;
+    cerr << "Options:" << endl;
+    cerr << "  --size n         Read text of n x n sudoku, where n is 9, 16 or 25" << endl;
+    cerr << "                   (default 9). Binary files have their own size" << endl;
+    cerr << "  --solutions      Read text of batch mode solutions, where a puzzle" << endl;
+    cerr << "                   without a solution is \"unsolvable\", \"timeout\"" << endl;
+    cerr << "                   or \"invalid\", and becomes an empty record" << endl;
+}
+
+// Returns true if the line is blank or a comment.
+bool isSkipped(const string &line) {
+    size_t first = line.find_first_not_of(" \t\r");
+    return first == string::npos || line[first] == '#';
+}
+
+// Returns true if the line is a batch mode result without a solution,
+// including puzzles that gave up on reaching the limits.
+bool isUnsolved(const string &line) {
+    istringstream iss(line);
+    string word;
+    iss >> word;
+    return word == "unsolvable" || word == "timeout" || word == "invalid";
+}
+
+// Writes every record of the binary file at data to out as one line of
+// symbols, or "unsolvable" for an empty record in a file of solutions.
+// Throws runtime_error if a record is malformed.
+template <int N>
+void binaryToText(const unsigned char *data, size_t size, ostream &out) {
+    BasicBinaryReader<N> reader(data, size);
+    bool solutions = reader.getHeader().solutions;
+
+    string buffer;
+    BasicSudoku<N> board;
+    while (reader.next(board)) {
+        bool empty = true;
+        for (int i=0; i<BasicSudoku<N>::NUM_CELLS && empty; ++i) {
+            empty = board.getCell(i % BasicSudoku<N>::SIZE, i / BasicSudoku<N>::SIZE) == 0;
+        }
+
+        if (solutions && empty) {
+            buffer += "unsolvable";
+        } else {
+            appendLine(buffer, board);
+        }
+        buffer.push_back('\n');
+        board = BasicSudoku<N>();
+
+        if (buffer.size() >= (1 << 16)) {
+            out.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    }
+    out.write(buffer.data(), buffer.size());
+}
+
+// Writes every puzzle read from in to out as a binary file, or every
+// solution if solutions is true. Returns the number of records. Throws
+// runtime_error if a puzzle is malformed.
+template <int N>
+uint64_t textToBinary(istream &in, ostream &out, bool solutions) {
+    BinaryHeader header;
+    header.boxSize = N;
+    header.solutions = solutions;
+
+    // The count is written once every record is
+    writeBinaryHeader(out, header);
+
+    vector<unsigned char> record(binaryRecordSize<N>());
+    BasicSudoku<N> board;
+    auto writeRecord = [&] {
+        packRecord(board, record.data());
+        out.write(reinterpret_cast<const char*>(record.data()), record.size());
+        board = BasicSudoku<N>();
+        ++header.count;
+    };
+
+    if (!solutions) {
+        BasicPuzzleReader<N> reader(in);
+        try {
+            while (reader.next(board)) writeRecord();
+        } catch (exception &e) {
+            throw runtime_error("Line " + to_string(reader.getLineNumber()) + ": "
+                                + e.what());
+        }
+    } else {
+        // Solutions are single lines, so they're read one line at a time
+        string line;
+        int lineNumber = 0;
+        while (getline(in, line)) {
+            ++lineNumber;
+            if (isSkipped(line)) continue;
+
+            if (!isUnsolved(line)) {
+                istringstream iss(line);
+                BasicPuzzleReader<N> reader(iss);
+                try {
+                    reader.next(board);
+                } catch (exception &e) {
+                    throw runtime_error("Line " + to_string(lineNumber) + ": " + e.what());
+                }
+            }
+            writeRecord();
+        }
+    }
+
+    out.seekp(0);
+    writeBinaryHeader(out, header);
+    return header.count;
+}
+
+int main(int argc, char *argv[])
+{
+    int size = 9;
+    bool solutions = false;
+    vector<const char*> paths;
+
+    // Parse command line options
+    for (int i=1; i<argc; ++i) {
+        if (strcmp(argv[i], "--size") == 0 && i+1 < argc) {
+            size = atoi(argv[++i]);
+            if (size != 9 && size != 16 && size != 25) {
+                cerr << "Size " << argv[i] << " is not 9, 16, or 25" << endl;
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--solutions") == 0) {
+            solutions = true;
+        } else if (argv[i][0] != '-' || strcmp(argv[i], "-") == 0) {
+            paths.push_back(argv[i]);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (paths.size() != 2) {
+        usage(argv[0]);
+        return 2;
+    }
+    string input = paths[0];
+    string output = paths[1];
+
+    try {
+        // Binary input is converted to text
+        unique_ptr<MappedFile> mapped;
+        if (input != "-") mapped = make_unique<MappedFile>(input);
+
+        if (mapped && isBinaryFormat(mapped->getData(), mapped->getSize())) {
+            ofstream file;
+            if (output != "-") {
+                file.open(output, ios::binary);
+                if (!file.is_open()) throw runtime_error("File " + output + " can't be written.");
+            }
+            ostream &out = (output != "-") ? file : cout;
+
+            const unsigned char *data = mapped->getData();
+            size_t dataSize = mapped->getSize();
+            int boxSize = readBinaryHeader(data, dataSize).boxSize;
+            if (boxSize == 4) {
+                binaryToText<4>(data, dataSize, out);
+            } else if (boxSize == 5) {
+                binaryToText<5>(data, dataSize, out);
+            } else {
+                binaryToText<3>(data, dataSize, out);
+            }
+
+            out.flush();
+            if (!out) throw runtime_error("File " + output + " can't be written.");
+            return 0;
+        }
+        mapped.reset();
+
+        // Text input is converted to binary, which can't go to stdout since
+        // the header is written last
+        if (output == "-") throw runtime_error("Binary output must be a file");
+
+        ifstream inFile;
+        if (input != "-") {
+            inFile.open(input);
+            if (!inFile.is_open()) throw runtime_error("File " + input + " not found.");
+        }
+        istream &in = (input != "-") ? inFile : cin;
+
+        ofstream out(output, ios::binary);
+        if (!out.is_open()) throw runtime_error("File " + output + " can't be written.");
+
+        uint64_t count = (size == 16) ? textToBinary<4>(in, out, solutions)
+                         : (size == 25) ? textToBinary<5>(in, out, solutions)
+                         : textToBinary<3>(in, out, solutions);
+
+        out.flush();
+        if (!out) throw runtime_error("File " + output + " can't be written.");
+        cerr << "Wrote " << count << (solutions ? " solutions" : " puzzles") << endl;
+
+    } catch (exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,347 @@
+// sudoku-generate generates sudoku puzzles with exactly one solution, see
+// BasicGenerator, and writes them one per line, like the input of batch
+// mode, or in the packed binary format, see sudoku_binary.h. Puzzles are
+// generated on every core, and written in order, so a seed gives the same
+// file with any number of threads.
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <array>
+#include <memory>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include "sudoku_binary.h"
+#include "sudoku_generator.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+// Attempts at a puzzle before giving up on the targets.
+const int MAX_ATTEMPTS = 1000;
+
+// Prints command line usage
+void usage(const char *name) {
+    cerr << "Usage: " << name << " [options] count output" << endl;
+    cerr << "Generates count puzzles with a unique solution and writes them to output," << endl;
+    cerr << "or to stdout if output is -" << endl;
+    cerr << "Options:" << endl;
+    cerr << "  --size n         Generate n x n sudoku, where n is 9, 16 or 25 (default 9)" << endl;
+    cerr << "  --clues n        Stop removing clues at n clues (default: remove as" << endl;
+    cerr << "                   many as possible)" << endl;
+    cerr << "  --difficulty d   Only keep puzzles that are easy, solved by singles," << endl;
+    cerr << "                   medium, solved by pairs and intersections, or hard," << endl;
+    cerr << "                   which need guessing (default: any)" << endl;
+    cerr << "  --max-nodes n    Keep a clue if checking that the puzzle stays unique" << endl;
+    cerr << "                   without it takes more than n values tried (default" << endl;
+    cerr << "                   4 per cell)" << endl;
+    cerr << "  --seed s         Generate the puzzles of seed s (default 1)" << endl;
+    cerr << "  --threads n      Generate on n threads (default: one per hardware" << endl;
+    cerr << "                   thread)" << endl;
+    cerr << "  --binary         Write the packed binary format instead of text" << endl;
+    cerr << "  --solutions f    Also write the solutions to file f, in the same format" << endl;
+}
+
+// Generation options from the command line.
+struct Options {
+    long count = 0;
+    int numClues = 0;
+    long maxNodes = 0;
+    Difficulty difficulty = Difficulty::Any;
+    uint64_t seed = 1;
+    int numThreads = 0;
+    bool binary = false;
+};
+
+// Writes puzzles as text lines or binary records, in large blocks.
+template <int N>
+class PuzzleWriter {
+    ostream &out;
+    bool binary;
+    BinaryHeader header;
+    uint64_t numWritten = 0;
+    string buffer;
+    BasicSudoku<N> board;
+
+public:
+    // Writes the binary header of count records if binary is true.
+    PuzzleWriter(ostream &out, bool binary, bool solutions, long count)
+        : out(out), binary(binary) {
+        if (binary) {
+            header.boxSize = N;
+            header.solutions = solutions;
+            header.count = static_cast<uint64_t>(count);
+            writeBinaryHeader(out, header);
+        }
+    }
+
+    // Writes the puzzle in cells, row by row.
+    void write(const uint8_t *cells) {
+        ++numWritten;
+        board.loadCells(cells);
+        if (binary) {
+            size_t size = buffer.size();
+            buffer.resize(size + binaryRecordSize<N>());
+            packRecord(board, reinterpret_cast<unsigned char*>(&buffer[size]));
+        } else {
+            appendLine(buffer, board);
+            buffer.push_back('\n');
+        }
+
+        if (buffer.size() >= (1 << 16)) flush();
+    }
+
+    void flush() {
+        out.write(buffer.data(), buffer.size());
+        buffer.clear();
+        out.flush();
+    }
+
+    // Flushes, and if fewer records were written than the header promised,
+    // ex. when generation stopped early, rewrites the header with the real
+    // count. Only files can be rewritten, so a header written to a pipe
+    // keeps the count it had.
+    void finish() {
+        flush();
+        if (binary && numWritten != header.count && out.tellp() >= 0) {
+            header.count = numWritten;
+            out.seekp(0);
+            writeBinaryHeader(out, header);
+            out.flush();
+        }
+    }
+};
+
+// A puzzle in the window of puzzles being generated
+template <int N>
+struct Slot {
+    array<uint8_t, BasicSudoku<N>::NUM_CELLS> puzzle;
+    array<uint8_t, BasicSudoku<N>::NUM_CELLS> solution;
+    bool done = false;
+    // Attempts it took, or 0 if the targets weren't met.
+    int attempts = 0;
+};
+
+// Generates the puzzles of options on the workers of pool, and writes them
+// to out, and their solutions to solutionsOut if it isn't null. Throws
+// runtime_error if a puzzle doesn't meet the targets.
+// effects: writes to out and solutionsOut
+template <int N>
+void generate(const Options &options, ostream &out, ostream *solutionsOut
+              , ThreadPool &pool) {
+    // Generators keep solvers between puzzles, so every worker gets its own
+    BasicGenerator<N> generator;
+    generator.setNumClues(options.numClues);
+    generator.setDifficulty(options.difficulty);
+    generator.setMaxAttempts(MAX_ATTEMPTS);
+    if (options.maxNodes > 0) generator.setMaxNodes(options.maxNodes);
+    vector<BasicGenerator<N>> generators(pool.getNumThreads(), generator);
+
+    PuzzleWriter<N> puzzles(out, options.binary, false, options.count);
+    unique_ptr<PuzzleWriter<N>> solutions;
+    if (solutionsOut) {
+        solutions = make_unique<PuzzleWriter<N>>(*solutionsOut, options.binary
+                                                 , true, options.count);
+    }
+
+    // Enough puzzles in flight that every worker stays busy while the
+    // oldest puzzle is still being generated
+    const long window = max(64, 16 * pool.getNumThreads());
+    vector<Slot<N>> slots(window);
+
+    // Guards done of slots. Signalled when a puzzle is generated.
+    mutex doneMutex;
+    condition_variable done;
+
+    auto start = chrono::steady_clock::now();
+    long totalClues = 0;
+    long totalAttempts = 0;
+    long failed = -1;
+
+    // Puzzles head to tail - 1 are in the window
+    long head = 0;
+    long tail = 0;
+    while (head < options.count) {
+        // Stop submitting once a puzzle failed, but wait for the puzzles in
+        // flight, since they reference slots
+        while (failed < 0 && tail < options.count && tail - head < window) {
+            Slot<N> &slot = slots[tail % window];
+            slot.done = false;
+
+            pool.submit([&generators, &pool, &slot, &doneMutex, &done, &options
+                         , index = tail] {
+                BasicGenerator<N> &generator = generators[pool.getWorkerIndex()];
+                int attempts = generator.generate(options.seed, index, slot.puzzle.data()
+                                                  , slot.solution.data());
+
+                lock_guard<mutex> lock(doneMutex);
+                slot.attempts = attempts;
+                slot.done = true;
+                done.notify_one();
+            });
+            ++tail;
+        }
+        if (head == tail) break;
+
+        Slot<N> &slot = slots[head % window];
+        {
+            unique_lock<mutex> lock(doneMutex);
+            done.wait(lock, [&slot] { return slot.done; });
+        }
+
+        if (slot.attempts == 0 && failed < 0) failed = head;
+        if (failed < 0) {
+            puzzles.write(slot.puzzle.data());
+            if (solutions) solutions->write(slot.solution.data());
+
+            for (uint8_t cell : slot.puzzle) totalClues += cell != 0;
+            totalAttempts += slot.attempts;
+        }
+        ++head;
+    }
+
+    puzzles.finish();
+    if (solutions) solutions->finish();
+
+    if (failed >= 0) {
+        throw runtime_error("Puzzle " + to_string(failed + 1) + " didn't meet the targets in "
+                            + to_string(MAX_ATTEMPTS) + " attempts");
+    }
+
+    double totalMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cerr << "Generated " << options.count << " puzzles in " << totalMs
+         << " milliseconds on " << pool.getNumThreads() << " threads";
+    if (options.count > 0) {
+        cerr << ", " << options.count / (totalMs / 1000) << " puzzles per second, "
+             << static_cast<double>(totalClues) / options.count << " clues and "
+             << static_cast<double>(totalAttempts) / options.count
+             << " attempts per puzzle";
+    }
+    cerr << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    int size = 9;
+    Options options;
+    string solutionsPath;
+    vector<const char*> args;
+
+    // Parse command line options
+    for (int i=1; i<argc; ++i) {
+        if (strcmp(argv[i], "--size") == 0 && i+1 < argc) {
+            size = atoi(argv[++i]);
+            if (size != 9 && size != 16 && size != 25) {
+                cerr << "Size " << argv[i] << " is not 9, 16, or 25" << endl;
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--clues") == 0 && i+1 < argc) {
+            char *end;
+            options.numClues = static_cast<int>(strtol(argv[++i], &end, 10));
+            if (*end != '\0' || options.numClues < 1) {
+                cerr << "Clue count " << argv[i] << " is not a positive number" << endl;
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--difficulty") == 0 && i+1 < argc) {
+            string d = argv[++i];
+            if (d == "easy") {
+                options.difficulty = Difficulty::Easy;
+            } else if (d == "medium") {
+                options.difficulty = Difficulty::Medium;
+            } else if (d == "hard") {
+                options.difficulty = Difficulty::Hard;
+            } else if (d == "any") {
+                options.difficulty = Difficulty::Any;
+            } else {
+                cerr << "Difficulty " << d << " is not easy, medium, hard, or any" << endl;
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--max-nodes") == 0 && i+1 < argc) {
+            char *end;
+            options.maxNodes = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || options.maxNodes < 1) {
+                cerr << "Node limit " << argv[i] << " is not a positive number" << endl;
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--seed") == 0 && i+1 < argc) {
+            char *end;
+            options.seed = strtoull(argv[++i], &end, 10);
+            if (*end != '\0' || argv[i][0] == '-') {
+                cerr << "Seed " << argv[i] << " is not a number" << endl;
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--threads") == 0 && i+1 < argc) {
+            char *end;
+            options.numThreads = static_cast<int>(strtol(argv[++i], &end, 10));
+            if (*end != '\0' || options.numThreads < 1) {
+                cerr << "Thread count " << argv[i] << " is not a positive number" << endl;
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--binary") == 0) {
+            options.binary = true;
+        } else if (strcmp(argv[i], "--solutions") == 0 && i+1 < argc) {
+            solutionsPath = argv[++i];
+        } else if (argv[i][0] != '-' || strcmp(argv[i], "-") == 0) {
+            args.push_back(argv[i]);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (args.size() != 2) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    char *end;
+    options.count = strtol(args[0], &end, 10);
+    if (*end != '\0' || options.count < 0) {
+        cerr << "Puzzle count " << args[0] << " is not a number" << endl;
+        return 2;
+    }
+    string output = args[1];
+
+    try {
+        ofstream file;
+        if (output != "-") {
+            file.open(output, ios::binary);
+            if (!file.is_open()) throw runtime_error("File " + output + " can't be written.");
+        }
+        ostream &out = (output != "-") ? file : cout;
+
+        ofstream solutionsFile;
+        if (!solutionsPath.empty()) {
+            solutionsFile.open(solutionsPath, ios::binary);
+            if (!solutionsFile.is_open()) {
+                throw runtime_error("File " + solutionsPath + " can't be written.");
+            }
+        }
+        ostream *solutionsOut = solutionsPath.empty() ? nullptr : &solutionsFile;
+
+        ThreadPool pool(options.numThreads);
+        if (size == 16) {
+            generate<4>(options, out, solutionsOut, pool);
+        } else if (size == 25) {
+            generate<5>(options, out, solutionsOut, pool);
+        } else {
+            generate<3>(options, out, solutionsOut, pool);
+        }
+
+        if (!out) throw runtime_error("File " + output + " can't be written.");
+        if (solutionsOut && !*solutionsOut) {
+            throw runtime_error("File " + solutionsPath + " can't be written.");
+        }
+
+    } catch (exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
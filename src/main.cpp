@@ -1,152 +1,802 @@
-#include <iostream>
-#include <fstream>
-#include <string>
-#include <sstream>
-#include <exception>
-#include <chrono>
-#include "sudoku_backtrack.h"
-
-using namespace std;
-// C:\Users\fengw\Desktop\sudoku.txt
-
-// Prints the sudoku
-void print(const Sudoku &s) {
-    for (int y=0; y<9; ++y) {
-        for (int x=0; x<9; ++x) {
-            cout << s.getCell(x, y) << " ";
-        }
-        cout << endl;
-    }
-}
-
-// Returns the sudoku created from the file
-Sudoku read(ifstream &file) {
-
-    // Keeps track of which cell to write to
-    int x=0;
-    int y=0;
-
-    Sudoku s;
-    string line;
-
-    // Read lines from file
-    while (getline(file, line)) {
-        if (y >= 9) {
-            throw runtime_error("File has too many lines");
-        }
-
-        istringstream iss(line);
-
-        // Read characters from line
-        while (iss >> line) {
-            if (x >= 9) {
-                throw runtime_error("File has too many characters in line");
-            }
-            if (line.size() > 1 || !isdigit(line[0])) {
-                throw runtime_error("File has character " + line + " that is not a digit");
-            }
-
-            s.initCell(x, y, line[0] - '0');
-            ++x;
-        }
-        x=0;
-        ++y;
-    }
-
-    if (y < 9) {
-        throw runtime_error("File has too few lines");
-    }
-
-    return s;
-}
-
-int main()
-{
-    cout << "Name: Sudoku Solver" << endl;
-    cout << "Author: FengWei Pi" << endl << endl;
-    cout << "Welcome to Sudoku Solver!" << endl;
-    cout << "Commands:" << endl;
-    cout << "> solve filename" << endl;
-    cout << "> set heuristic 1/2/3" << endl;
-
-    SudokuBacktrack solver;
-    string cmd;
-
-    // Keep reading commands from cin
-    while (true) {
-        cout << endl << "Please enter a command:" << endl;
-        if (!getline(cin, cmd)) break;
-
-        istringstream iss(cmd);
-        getline(iss, cmd, ' ');
-
-        // Handle solve command
-        if (cmd == "solve") {
-            getline(iss, cmd);
-
-            // Open file
-            ifstream file(cmd);
-            if (!file.is_open()) {
-                cout << "File " << cmd << " not found." << endl;
-                continue;
-            }
-
-            // Solve
-            try {
-                Sudoku sudoku = read(file);
-
-                cout << "Read in sudoku" << endl;
-                print(sudoku);
-
-                auto start = chrono::high_resolution_clock::now();
-                auto finish = start;
-
-                if (solver.solve(sudoku)) {
-                    finish = std::chrono::high_resolution_clock::now();
-
-                    cout << endl << "A solution is" << endl;
-                    print(sudoku);
-                } else {
-                    finish = std::chrono::high_resolution_clock::now();
-
-                    cout << "Sudoku has no solution" << endl;
-                }
-                auto timeTaken = chrono::duration_cast<chrono::milliseconds>(finish - start).count();
-                cout << "Took " << timeTaken << " milliseconds" << endl;
-
-            } catch (exception &e) {
-                cout << e.what() << endl;
-            }
-        }
-        // Handle set heuristic
-        else if (cmd == "set" && iss >> cmd && cmd == "heuristic") {
-            if (!(iss >> cmd)) {
-                cout << "No digit entered" << endl;
-                continue;
-            }
-
-            int val = cmd[0] - '0';
-            if (val < 1 || val > 3) {
-                cout << "Character " << cmd << " is not 1, 2, or 3" << endl;
-                continue;
-            }
-
-            solver.setHeuristic(val);
-            cout << "Heuristic " << val << " set. ";
-            if (val == 1) {
-                cout << "No heuristic used." << endl;
-            } else if (val == 2) {
-                cout << "Forward checking used." << endl;
-            } else {
-                cout << "Forward checking used with minimum remaining values," << endl;
-                cout << "most constraining variable, and least constraining value." << endl;
-            }
-        }
-        // Entered input not a command
-        else {
-            cout << cmd << " is not a command" << endl;
-        }
-    } // End while(true)
-
-    return 0;
-}
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <sstream>
+#include <exception>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include "batch.h"
+#include "solution_cache.h"
+#include "sudoku_binary.h"
+#include "sudoku_server.h"
+#include "sudoku_backtrack.h"
+#include "sudoku_dlx.h"
+#include "sudoku_sat.h"
+#include "sudoku_portfolio.h"
+
+#if SUDOKU_SERVER
+#include <csignal>
+#include <pthread.h>
+#endif
+
+using namespace std;
+// C:\Users\fengw\Desktop\sudoku.txt
+
+// Prints the sudoku
+template <int N>
+void print(const BasicSudoku<N> &s) {
+    const int SIZE = BasicSudoku<N>::SIZE;
+    for (int y=0; y<SIZE; ++y) {
+        for (int x=0; x<SIZE; ++x) {
+            // Line up the columns of sudoku with two digit values
+            if (SIZE > 9 && s.getCell(x, y) < 10) cout << " ";
+            cout << s.getCell(x, y) << " ";
+        }
+        cout << endl;
+    }
+}
+
+// Returns the sudoku created from the file
+template <int N>
+BasicSudoku<N> read(ifstream &file) {
+    const int SIZE = BasicSudoku<N>::SIZE;
+
+    // Keeps track of which cell to write to
+    int x=0;
+    int y=0;
+
+    BasicSudoku<N> s;
+    string line;
+
+    // Read lines from file
+    while (getline(file, line)) {
+        if (y >= SIZE) {
+            throw runtime_error("File has too many lines");
+        }
+
+        istringstream iss(line);
+
+        // Read values from line. A value is a single symbol, or a number of
+        // two digits for sudoku larger than 9x9.
+        while (iss >> line) {
+            if (x >= SIZE) {
+                throw runtime_error("File has too many characters in line");
+            }
+
+            int value = -1;
+            if (line.size() == 1) {
+                value = symbolValue(line[0]);
+            } else if (line.size() == 2 && isdigit(line[0]) && isdigit(line[1])) {
+                value = stoi(line);
+            }
+            if (value < 0 || value > SIZE) {
+                throw runtime_error("File has " + line + " that is not a value from 0 to "
+                                    + to_string(SIZE));
+            }
+
+            s.initCell(x, y, value);
+            ++x;
+        }
+        x=0;
+        ++y;
+    }
+
+    if (y < SIZE) {
+        throw runtime_error("File has too few lines");
+    }
+
+    return s;
+}
+
+// Prints the stats of a search, if stats are enabled
+void printStats(const SearchStats &stats) {
+    if (!STATS_ENABLED) return;
+
+    cout << "Searched " << stats.nodes << " nodes with " << stats.backtracks
+         << " backtracks, " << stats.backjumps << " of them backjumps, "
+         << stats.maxDepth << " deep" << endl;
+    cout << "Forward checking removed " << stats.valuesPruned
+         << " values, inferences removed or assigned " << stats.valuesPropagated << endl;
+    cout << "Choosing cells took "
+         << chrono::duration<double, milli>(stats.varOrderingTime).count()
+         << " milliseconds, ordering values took "
+         << chrono::duration<double, milli>(stats.valueOrderingTime).count()
+         << " milliseconds" << endl;
+}
+
+// Prints how often each engine of solver answered first, if it's a
+// portfolio.
+template <int N>
+void printWins(const BasicSudokuSolver<N> &solver) {
+    auto *portfolio = dynamic_cast<const BasicPortfolioSolver<N>*>(&solver);
+    if (portfolio == nullptr) return;
+
+    cerr << "Answered first:";
+    for (int i=0; i<portfolio->getNumSolvers(); ++i) {
+        cerr << (i > 0 ? ", " : " ") << portfolio->getName(i) << " "
+             << portfolio->getNumWins(i);
+    }
+    cerr << endl;
+}
+
+// Number of puzzles cached if only a cache file is given.
+const size_t DEFAULT_CACHE_SIZE = 100000;
+
+// Prints command line usage
+void usage(const char *name) {
+    cerr << "Usage: " << name << " [options]" << endl;
+    cerr << "Without --batch, starts the interactive console." << endl;
+    cerr << "Options:" << endl;
+    cerr << "  --batch [file]   Solve every puzzle in file, or stdin if file is" << endl;
+    cerr << "                   - or missing, and print one solution per line." << endl;
+    cerr << "                   Binary files are read with their own size" << endl;
+    cerr << "  --count n        In batch mode, print the number of solutions of" << endl;
+    cerr << "                   each puzzle instead, counting up to n" << endl;
+    cerr << "  --unique         Same as --count 2. Prints 1 for puzzles with a" << endl;
+    cerr << "                   unique solution" << endl;
+    cerr << "  --engine name    Solve with backtrack, dlx, sat, or portfolio, which" << endl;
+    cerr << "                   races several engines (default backtrack)" << endl;
+    cerr << "  --heuristic x    Set the backtrack heuristic to 1, 2 or 3 (default 3)" << endl;
+    cerr << "  --inference x    Set the backtrack inference level to 0, 1 or 2" << endl;
+    cerr << "                   (default 0)" << endl;
+    cerr << "  --backjump x     Set the backtrack backjumping level to 0, none, 1," << endl;
+    cerr << "                   back to the cause of the failures, or 2, also" << endl;
+    cerr << "                   learning nogoods (default 0)" << endl;
+    cerr << "  --size n         Solve n x n sudoku, where n is 9, 16 or 25 (default" << endl;
+    cerr << "                   9). Dancing links only solves 9x9 sudoku" << endl;
+    cerr << "  --threads n      Solve on n threads (default: one per hardware" << endl;
+    cerr << "                   thread). Batch mode solves one puzzle per thread," << endl;
+    cerr << "                   the console splits each puzzle over the threads" << endl;
+    cerr << "  --cache n        In batch mode, remember the solutions of the last n" << endl;
+    cerr << "                   puzzles, so repeated and symmetric puzzles aren't" << endl;
+    cerr << "                   searched again. Counting solutions isn't cached" << endl;
+    cerr << "  --cache-file f   Load the cache from file f if it exists, and save it" << endl;
+    cerr << "                   there after the batch. Caches " << DEFAULT_CACHE_SIZE << " puzzles" << endl;
+    cerr << "                   unless --cache is given" << endl;
+    cerr << "  --timeout ms     In batch and server mode, give up on puzzles not" << endl;
+    cerr << "                   solved within ms milliseconds, and print timeout" << endl;
+    cerr << "  --max-nodes n    Same as --timeout, but give up after trying n values" << endl;
+#if SUDOKU_SERVER
+    cerr << "  --server path    Listen on the Unix socket at path and solve the" << endl;
+    cerr << "                   puzzles sent by clients, one per line, until" << endl;
+    cerr << "                   stopped with SIGINT or SIGTERM" << endl;
+#endif
+}
+
+// Solves every puzzle read by reader on numThreads threads and writes one
+// line per puzzle to cout. If countLimit > 0, counts solutions up to
+// countLimit instead, or gives up on puzzles that reach limits. If
+// cacheSize > 0, caches the solutions of up to
+// cacheSize puzzles, loaded from and saved to cacheFile if it isn't null.
+// Prints the aggregate timing to cerr. Returns the exit code of the program.
+template <int N>
+int runBatch(BasicPuzzleSource<N> &reader, const BasicSudokuSolver<N> &solver
+             , int numThreads, int countLimit, const SolveLimits &limits
+             , size_t cacheSize, const char *cacheFile) {
+    ThreadPool pool(numThreads);
+
+    shared_ptr<BasicSolutionCache<N>> cache;
+    unique_ptr<BasicSudokuSolver<N>> cachedSolver;
+    if (cacheSize > 0) {
+        cache = make_shared<BasicSolutionCache<N>>(cacheSize);
+        if (cacheFile != nullptr) {
+            ifstream file(cacheFile);
+            try {
+                if (file.is_open()) cache->load(file);
+            } catch (exception &e) {
+                cerr << "Cache file " << cacheFile << ": " << e.what() << endl;
+                return 2;
+            }
+        }
+        cachedSolver = make_unique<BasicCachedSolver<N>>(solver.clone(), cache);
+    }
+
+    auto start = chrono::steady_clock::now();
+    BatchStats stats = solveBatch(reader, cout, cerr
+                                  , cachedSolver ? *cachedSolver : solver
+                                  , pool, countLimit, limits);
+    auto finish = chrono::steady_clock::now();
+
+    double totalMs = chrono::duration<double, milli>(finish - start).count();
+    double solveMs = chrono::duration<double, milli>(stats.solveTime).count();
+
+    cerr << "Solved " << stats.numSolved << " of " << stats.numPuzzles << " puzzles";
+    if (stats.numInvalid > 0) cerr << " (" << stats.numInvalid << " invalid)";
+    if (stats.numTimedOut > 0) cerr << " (" << stats.numTimedOut << " timed out)";
+    cerr << " in " << totalMs << " milliseconds on " << pool.getNumThreads()
+         << " threads" << endl;
+    cerr << "Solving took " << solveMs << " milliseconds";
+    if (stats.numPuzzles > 0) {
+        cerr << ", " << solveMs / stats.numPuzzles << " milliseconds per puzzle, "
+             << stats.numPuzzles / (totalMs / 1000) << " puzzles per second";
+    }
+    cerr << endl;
+
+    printWins(solver);
+
+    if (cache) {
+        cerr << "Cache found " << cache->getNumHits() << " of "
+             << cache->getNumHits() + cache->getNumMisses() << " puzzles, and holds "
+             << cache->size() << " puzzles" << endl;
+
+        if (cacheFile != nullptr) {
+            ofstream file(cacheFile);
+            cache->save(file);
+            if (!file) {
+                cerr << "Cache file " << cacheFile << " can't be written." << endl;
+                return 2;
+            }
+        }
+    }
+
+    return stats.numInvalid > 0 ? 1 : 0;
+}
+
+#if SUDOKU_SERVER
+// Solves the puzzles sent to the Unix socket at path with solver on
+// numThreads threads until the process gets SIGINT or SIGTERM. If
+// countLimit > 0, counts solutions up to countLimit instead, or gives up on
+// puzzles that reach limits. Returns the exit code of the program.
+template <int N>
+int runServer(const char *path, const BasicSudokuSolver<N> &solver, int numThreads
+              , int countLimit, const SolveLimits &limits) {
+    // Block the stop signals in every thread, and wait for them on one
+    // thread, so the server isn't stopped from a signal handler
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    unique_ptr<BasicSudokuServer<N>> server;
+    try {
+        server = make_unique<BasicSudokuServer<N>>(path, solver, numThreads, countLimit
+                                                   , limits);
+    } catch (exception &e) {
+        cerr << e.what() << endl;
+        return 2;
+    }
+
+    thread waiter([&] {
+        int signal;
+        sigwait(&signals, &signal);
+        server->stop();
+    });
+
+    cerr << "Listening on " << path << " with " << server->getNumThreads()
+         << " threads" << endl;
+    server->run();
+    waiter.join();
+    printWins(solver);
+    return 0;
+}
+#endif
+
+// Returns the solver for the engine with the given name, or nullptr if
+// there is no engine with that name.
+SudokuSolver *findEngine(const string &name, SudokuBacktrack &backtrack
+                         , SudokuDLX &dlx, SudokuSAT &sat, PortfolioSolver &portfolio) {
+    if (name == "backtrack") return &backtrack;
+    if (name == "dlx") return &dlx;
+    if (name == "sat") return &sat;
+    if (name == "portfolio") return &portfolio;
+    return nullptr;
+}
+
+// Solves the sudoku in the file with the given name with solver, and
+// prints the solution. If backtrack isn't null, it's the same solver as
+// solver, and the search is split over the threads of pool.
+template <int N>
+void solveFile(const string &name, BasicSudokuSolver<N> &solver
+               , BasicSudokuBacktrack<N> *backtrack, ThreadPool &pool) {
+    // Open file
+    ifstream file(name);
+    if (!file.is_open()) {
+        cout << "File " << name << " not found." << endl;
+        return;
+    }
+
+    // Solve
+    try {
+        BasicSudoku<N> sudoku = read<N>(file);
+
+        cout << "Read in sudoku" << endl;
+        print(sudoku);
+
+        auto start = chrono::high_resolution_clock::now();
+        auto finish = start;
+
+        bool solved = (backtrack != nullptr && pool.getNumThreads() > 1)
+                      ? backtrack->solveParallel(sudoku, pool)
+                      : solver.solve(sudoku);
+
+        if (solved) {
+            finish = std::chrono::high_resolution_clock::now();
+
+            cout << endl << "A solution is" << endl;
+            print(sudoku);
+        } else {
+            finish = std::chrono::high_resolution_clock::now();
+
+            cout << "Sudoku has no solution" << endl;
+        }
+        auto timeTaken = chrono::duration_cast<chrono::milliseconds>(finish - start).count();
+        cout << "Took " << timeTaken << " milliseconds" << endl;
+        auto *portfolio = dynamic_cast<BasicPortfolioSolver<N>*>(&solver);
+        if (portfolio != nullptr && portfolio->getLastWinner() >= 0) {
+            cout << "Answered first by " << portfolio->getName(portfolio->getLastWinner())
+                 << endl;
+        }
+        printStats(solver.getStats());
+
+    } catch (exception &e) {
+        cout << e.what() << endl;
+    }
+}
+
+// Counts the solutions of the sudoku in the file with the given name with
+// solver, and prints whether it has none, one, or more.
+template <int N>
+void countFile(const string &name, BasicSudokuSolver<N> &solver) {
+    // Open file
+    ifstream file(name);
+    if (!file.is_open()) {
+        cout << "File " << name << " not found." << endl;
+        return;
+    }
+
+    // Count solutions, stopping at 2 since that's enough to tell
+    // whether the solution is unique
+    try {
+        BasicSudoku<N> sudoku = read<N>(file);
+
+        auto start = chrono::high_resolution_clock::now();
+        int numSolutions = solver.countSolutions(sudoku, 2);
+        auto finish = chrono::high_resolution_clock::now();
+
+        if (numSolutions == 0) {
+            cout << "Sudoku has no solution" << endl;
+        } else if (numSolutions == 1) {
+            cout << "Sudoku has a unique solution" << endl;
+        } else {
+            cout << "Sudoku has more than one solution" << endl;
+        }
+        auto timeTaken = chrono::duration_cast<chrono::milliseconds>(finish - start).count();
+        cout << "Took " << timeTaken << " milliseconds" << endl;
+        printStats(solver.getStats());
+
+    } catch (exception &e) {
+        cout << e.what() << endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    SudokuBacktrack backtrack;
+    SudokuDLX dlx;
+    SudokuSAT sat;
+    SudokuSolver *solver = &backtrack;
+
+    // Larger sudoku are solved by backtracking search, with the same
+    // settings as backtrack, by the SAT solver, or by a portfolio
+    BasicSudokuBacktrack<4> backtrack16;
+    BasicSudokuBacktrack<5> backtrack25;
+    BasicSudokuSAT<4> sat16;
+    BasicSudokuSAT<5> sat25;
+    unique_ptr<PortfolioSolver> portfolio = makeDefaultPortfolio<3>();
+    unique_ptr<BasicPortfolioSolver<4>> portfolio16 = makeDefaultPortfolio<4>();
+    unique_ptr<BasicPortfolioSolver<5>> portfolio25 = makeDefaultPortfolio<5>();
+    BasicSudokuSolver<4> *solver16 = &backtrack16;
+    BasicSudokuSolver<5> *solver25 = &backtrack25;
+    auto setEngine = [&](SudokuSolver *engine) {
+        solver = engine;
+        if (engine == portfolio.get()) {
+            solver16 = portfolio16.get();
+            solver25 = portfolio25.get();
+        } else if (engine == &sat) {
+            solver16 = &sat16;
+            solver25 = &sat25;
+        } else {
+            solver16 = &backtrack16;
+            solver25 = &backtrack25;
+        }
+    };
+    auto setHeuristic = [&](int h) {
+        backtrack.setHeuristic(h);
+        backtrack16.setHeuristic(h);
+        backtrack25.setHeuristic(h);
+    };
+    auto setInference = [&](int i) {
+        backtrack.setInference(i);
+        backtrack16.setInference(i);
+        backtrack25.setInference(i);
+    };
+    auto setBackjumping = [&](int b) {
+        backtrack.setBackjumping(b);
+        backtrack16.setBackjumping(b);
+        backtrack25.setBackjumping(b);
+    };
+
+    // Width of the sudoku solved
+    int size = 9;
+    bool batch = false;
+    const char *batchFile = nullptr;
+    int numThreads = 0;
+    int countLimit = 0;
+    SolveLimits limits;
+    size_t cacheSize = 0;
+    const char *cacheFile = nullptr;
+    const char *serverPath = nullptr;
+
+    // Parse command line options
+    for (int i=1; i<argc; ++i) {
+        if (strcmp(argv[i], "--batch") == 0) {
+            batch = true;
+            if (i+1 < argc && argv[i+1][0] != '-') {
+                batchFile = argv[++i];
+            } else if (i+1 < argc && strcmp(argv[i+1], "-") == 0) {
+                ++i;
+            }
+        } else if (strcmp(argv[i], "--heuristic") == 0 && i+1 < argc) {
+            int val = argv[++i][0] - '0';
+            if (val < 1 || val > 3 || argv[i][1] != '\0') {
+                cerr << "Heuristic " << argv[i] << " is not 1, 2, or 3" << endl;
+                return 2;
+            }
+            setHeuristic(val);
+        } else if (strcmp(argv[i], "--inference") == 0 && i+1 < argc) {
+            int val = argv[++i][0] - '0';
+            if (val < 0 || val > 2 || argv[i][1] != '\0') {
+                cerr << "Inference level " << argv[i] << " is not 0, 1, or 2" << endl;
+                return 2;
+            }
+            setInference(val);
+        } else if (strcmp(argv[i], "--backjump") == 0 && i+1 < argc) {
+            int val = argv[++i][0] - '0';
+            if (val < 0 || val > 2 || argv[i][1] != '\0') {
+                cerr << "Backjumping level " << argv[i] << " is not 0, 1, or 2" << endl;
+                return 2;
+            }
+            setBackjumping(val);
+        } else if (strcmp(argv[i], "--engine") == 0 && i+1 < argc) {
+            SudokuSolver *engine = findEngine(argv[++i], backtrack, dlx, sat, *portfolio);
+            if (engine == nullptr) {
+                cerr << "Engine " << argv[i] << " is not backtrack, dlx, sat, or portfolio" << endl;
+                return 2;
+            }
+            setEngine(engine);
+        } else if (strcmp(argv[i], "--count") == 0 && i+1 < argc) {
+            char *end;
+            countLimit = static_cast<int>(strtol(argv[++i], &end, 10));
+            if (*end != '\0' || countLimit < 1) {
+                cerr << "Count limit " << argv[i] << " is not a positive number" << endl;
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--unique") == 0) {
+            countLimit = 2;
+        } else if (strcmp(argv[i], "--size") == 0 && i+1 < argc) {
+            size = atoi(argv[++i]);
+            if (size != 9 && size != 16 && size != 25) {
+                cerr << "Size " << argv[i] << " is not 9, 16, or 25" << endl;
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--threads") == 0 && i+1 < argc) {
+            char *end;
+            numThreads = static_cast<int>(strtol(argv[++i], &end, 10));
+            if (*end != '\0' || numThreads < 1) {
+                cerr << "Thread count " << argv[i] << " is not a positive number" << endl;
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--timeout") == 0 && i+1 < argc) {
+            char *end;
+            long val = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || val < 1) {
+                cerr << "Timeout " << argv[i] << " is not a positive number" << endl;
+                return 2;
+            }
+            limits.timeout = chrono::milliseconds(val);
+        } else if (strcmp(argv[i], "--max-nodes") == 0 && i+1 < argc) {
+            char *end;
+            limits.maxNodes = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || limits.maxNodes < 1) {
+                cerr << "Node limit " << argv[i] << " is not a positive number" << endl;
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--cache") == 0 && i+1 < argc) {
+            char *end;
+            long val = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || val < 1) {
+                cerr << "Cache size " << argv[i] << " is not a positive number" << endl;
+                return 2;
+            }
+            cacheSize = static_cast<size_t>(val);
+        } else if (strcmp(argv[i], "--cache-file") == 0 && i+1 < argc) {
+            cacheFile = argv[++i];
+#if SUDOKU_SERVER
+        } else if (strcmp(argv[i], "--server") == 0 && i+1 < argc) {
+            serverPath = argv[++i];
+#endif
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (cacheFile != nullptr && cacheSize == 0) cacheSize = DEFAULT_CACHE_SIZE;
+
+    if (size != 9 && solver == &dlx) {
+        cerr << "Dancing links only solves 9x9 sudoku" << endl;
+        return 2;
+    }
+
+#if SUDOKU_SERVER
+    if (serverPath != nullptr) {
+        if (size == 16) {
+            return runServer(serverPath, *solver16, numThreads, countLimit, limits);
+        }
+        if (size == 25) {
+            return runServer(serverPath, *solver25, numThreads, countLimit, limits);
+        }
+        return runServer(serverPath, *solver, numThreads, countLimit, limits);
+    }
+#endif
+
+    // Non-interactive batch mode
+    if (batch) {
+        ios::sync_with_stdio(false);
+
+        // Binary files are solved straight from the mapped file
+        unique_ptr<MappedFile> mapped;
+        if (batchFile != nullptr) {
+            try {
+                mapped = make_unique<MappedFile>(batchFile);
+            } catch (exception &e) {
+                cerr << e.what() << endl;
+                return 2;
+            }
+        }
+        if (mapped && isBinaryFormat(mapped->getData(), mapped->getSize())) {
+            try {
+                const unsigned char *data = mapped->getData();
+                size_t dataSize = mapped->getSize();
+                int boxSize = readBinaryHeader(data, dataSize).boxSize;
+                if (boxSize != 3 && solver == &dlx) {
+                    cerr << "Dancing links only solves 9x9 sudoku" << endl;
+                    return 2;
+                }
+
+                if (boxSize == 4) {
+                    BasicBinaryReader<4> reader(data, dataSize);
+                    return runBatch(reader, *solver16, numThreads, countLimit
+                                    , limits, cacheSize, cacheFile);
+                }
+                if (boxSize == 5) {
+                    BasicBinaryReader<5> reader(data, dataSize);
+                    return runBatch(reader, *solver25, numThreads, countLimit
+                                    , limits, cacheSize, cacheFile);
+                }
+                BinaryReader reader(data, dataSize);
+                return runBatch(reader, *solver, numThreads, countLimit, limits
+                                , cacheSize, cacheFile);
+            } catch (exception &e) {
+                cerr << "File " << batchFile << ": " << e.what() << endl;
+                return 2;
+            }
+        }
+        mapped.reset();
+
+        ifstream file;
+        if (batchFile != nullptr) {
+            file.open(batchFile);
+            if (!file.is_open()) {
+                cerr << "File " << batchFile << " not found." << endl;
+                return 2;
+            }
+        }
+        istream &in = (batchFile != nullptr) ? file : cin;
+
+        if (size == 16) {
+            BasicPuzzleReader<4> reader(in);
+            return runBatch(reader, *solver16, numThreads, countLimit, limits, cacheSize
+                            , cacheFile);
+        }
+        if (size == 25) {
+            BasicPuzzleReader<5> reader(in);
+            return runBatch(reader, *solver25, numThreads, countLimit, limits, cacheSize
+                            , cacheFile);
+        }
+        PuzzleReader reader(in);
+        return runBatch(reader, *solver, numThreads, countLimit, limits, cacheSize
+                        , cacheFile);
+    }
+
+    cout << "Name: Sudoku Solver" << endl;
+    cout << "Author: FengWei Pi" << endl << endl;
+    cout << "Welcome to Sudoku Solver!" << endl;
+    cout << "Commands:" << endl;
+    cout << "> solve filename" << endl;
+    cout << "> count filename" << endl;
+    cout << "> set engine backtrack/dlx/sat/portfolio" << endl;
+    cout << "> set heuristic 1/2/3" << endl;
+    cout << "> set inference 0/1/2" << endl;
+    cout << "> set backjump 0/1/2" << endl;
+    cout << "> set size 9/16/25" << endl;
+    cout << "> set threads n" << endl;
+
+    // Hard puzzles are split over the threads of pool
+    unique_ptr<ThreadPool> pool = make_unique<ThreadPool>(numThreads);
+    string cmd;
+
+    // Keep reading commands from cin
+    while (true) {
+        cout << endl << "Please enter a command:" << endl;
+        if (!getline(cin, cmd)) break;
+
+        istringstream iss(cmd);
+        getline(iss, cmd, ' ');
+
+        // Option changed by a set command
+        string option;
+        bool isSet = (cmd == "set" && iss >> option);
+
+        // Handle solve command
+        if (cmd == "solve") {
+            getline(iss, cmd);
+
+            if (size == 16) {
+                solveFile(cmd, *solver16, solver16 == &backtrack16 ? &backtrack16 : nullptr
+                          , *pool);
+            } else if (size == 25) {
+                solveFile(cmd, *solver25, solver25 == &backtrack25 ? &backtrack25 : nullptr
+                          , *pool);
+            } else {
+                solveFile(cmd, *solver, solver == &backtrack ? &backtrack : nullptr, *pool);
+            }
+        }
+        // Handle count command
+        else if (cmd == "count") {
+            getline(iss, cmd);
+
+            if (size == 16) {
+                countFile(cmd, *solver16);
+            } else if (size == 25) {
+                countFile(cmd, *solver25);
+            } else {
+                countFile(cmd, *solver);
+            }
+        }
+        // Handle set threads
+        else if (isSet && option == "threads") {
+            int val = 0;
+            if (!(iss >> val) || val < 1) {
+                cout << "Number of threads must be a positive number" << endl;
+                continue;
+            }
+
+            pool = make_unique<ThreadPool>(val);
+            cout << "Solving on " << val << " threads." << endl;
+        }
+        // Handle set engine
+        else if (isSet && option == "engine") {
+            if (!(iss >> cmd)) {
+                cout << "No engine entered" << endl;
+                continue;
+            }
+
+            SudokuSolver *engine = findEngine(cmd, backtrack, dlx, sat, *portfolio);
+            if (engine == nullptr) {
+                cout << "Engine " << cmd << " is not backtrack, dlx, sat, or portfolio" << endl;
+                continue;
+            }
+            if (engine == &dlx && size != 9) {
+                cout << "Dancing links only solves 9x9 sudoku" << endl;
+                continue;
+            }
+
+            setEngine(engine);
+            if (solver == &backtrack) {
+                cout << "Backtracking search used." << endl;
+            } else if (solver == &dlx) {
+                cout << "Dancing links used." << endl;
+            } else if (solver == &sat) {
+                cout << "SAT solver used." << endl;
+            } else {
+                cout << "Portfolio of engines used." << endl;
+            }
+        }
+        // Handle set heuristic
+        else if (isSet && option == "heuristic") {
+            if (!(iss >> cmd)) {
+                cout << "No digit entered" << endl;
+                continue;
+            }
+
+            int val = cmd[0] - '0';
+            if (val < 1 || val > 3) {
+                cout << "Character " << cmd << " is not 1, 2, or 3" << endl;
+                continue;
+            }
+
+            setHeuristic(val);
+            cout << "Heuristic " << val << " set. ";
+            if (val == 1) {
+                cout << "No heuristic used." << endl;
+            } else if (val == 2) {
+                cout << "Forward checking used." << endl;
+            } else {
+                cout << "Forward checking used with minimum remaining values," << endl;
+                cout << "most constraining variable, and least constraining value." << endl;
+            }
+        }
+        // Handle set inference
+        else if (isSet && option == "inference") {
+            if (!(iss >> cmd)) {
+                cout << "No digit entered" << endl;
+                continue;
+            }
+
+            int val = cmd[0] - '0';
+            if (val < 0 || val > 2) {
+                cout << "Character " << cmd << " is not 0, 1, or 2" << endl;
+                continue;
+            }
+
+            setInference(val);
+            cout << "Inference level " << val << " set. ";
+            if (val == 0) {
+                cout << "No inferences made." << endl;
+            } else if (val == 1) {
+                cout << "Naked and hidden singles used." << endl;
+            } else {
+                cout << "Naked and hidden singles and pairs, pointing, and" << endl;
+                cout << "box line reduction used." << endl;
+            }
+        }
+        // Handle set backjump
+        else if (isSet && option == "backjump") {
+            if (!(iss >> cmd)) {
+                cout << "No digit entered" << endl;
+                continue;
+            }
+
+            int val = cmd[0] - '0';
+            if (val < 0 || val > 2) {
+                cout << "Character " << cmd << " is not 0, 1, or 2" << endl;
+                continue;
+            }
+
+            setBackjumping(val);
+            cout << "Backjumping level " << val << " set. ";
+            if (val == 0) {
+                cout << "Chronological backtracking used." << endl;
+            } else if (val == 1) {
+                cout << "Conflict-directed backjumping used." << endl;
+            } else {
+                cout << "Conflict-directed backjumping used with nogood learning." << endl;
+            }
+        }
+        // Handle set size
+        else if (isSet && option == "size") {
+            int val = 0;
+            if (!(iss >> val) || (val != 9 && val != 16 && val != 25)) {
+                cout << "Size must be 9, 16, or 25" << endl;
+                continue;
+            }
+            if (val != 9 && solver == &dlx) {
+                cout << "Dancing links only solves 9x9 sudoku" << endl;
+                continue;
+            }
+
+            size = val;
+            cout << "Solving " << val << "x" << val << " sudoku." << endl;
+        }
+        // Entered input not a command
+        else {
+            cout << cmd << " is not a command" << endl;
+        }
+    } // End while(true)
+
+    return 0;
+}
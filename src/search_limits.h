@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+
+// Result of a search that can give up before it finishes.
+enum class SolveResult {
+    Solved,
+    Unsolvable,
+
+    // The search ran out of time or nodes, see SearchLimits.
+    TimedOut,
+
+    // The search was cancelled with its CancelToken.
+    Cancelled
+};
+
+// CancelToken lets another thread stop a search. Once cancelled, it stays
+// cancelled, and every search using it gives up soon after. A token with a
+// parent is also cancelled once its parent is.
+class CancelToken {
+    std::atomic<bool> cancelled{false};
+    const CancelToken *parent;
+
+public:
+    // parent must outlive the token, if it isn't null.
+    explicit CancelToken(const CancelToken *parent = nullptr) : parent(parent) {}
+
+    inline void cancel() {
+        cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    inline bool isCancelled() const {
+        return cancelled.load(std::memory_order_relaxed)
+               || (parent != nullptr && parent->isCancelled());
+    }
+};
+
+// SearchLimits bounds the work done by one search. The default limits never
+// stop a search.
+struct SearchLimits {
+    using Clock = std::chrono::steady_clock;
+
+    // The search gives up once this time has passed.
+    Clock::time_point deadline = Clock::time_point::max();
+
+    // The search gives up after trying this many values, if > 0.
+    long maxNodes = 0;
+
+    // The search gives up once this is cancelled, if it isn't null. Must
+    // outlive the search.
+    const CancelToken *cancel = nullptr;
+};
+
+// SolveLimits bounds every solve of a batch or a server. The time starts
+// when each solve does. Zero means no limit.
+struct SolveLimits {
+    std::chrono::nanoseconds timeout{0};
+    long maxNodes = 0;
+
+    inline bool isUnlimited() const {
+        return timeout.count() <= 0 && maxNodes <= 0;
+    }
+
+    // Returns the limits of a solve starting now, which also gives up once
+    // cancel is cancelled, if it isn't null.
+    SearchLimits start(const CancelToken *cancel = nullptr) const {
+        SearchLimits limits;
+        if (timeout.count() > 0) limits.deadline = SearchLimits::Clock::now() + timeout;
+        limits.maxNodes = maxNodes;
+        limits.cancel = cancel;
+        return limits;
+    }
+};
+
+// SearchBudget counts the nodes of one search against its SearchLimits.
+// The clock and the cancel token are only checked every CHECK_INTERVAL
+// nodes, so a node costs an increment and a comparison.
+class SearchBudget {
+    const SearchLimits *limits;
+    long nodes = 0;
+
+    // Number of nodes at which the limits are checked next.
+    long nextCheck;
+
+    // Why the search was stopped, if it was.
+    bool stopped = false;
+    SolveResult reason = SolveResult::TimedOut;
+
+    bool check() {
+        if (!stopped) {
+            if (limits->cancel != nullptr && limits->cancel->isCancelled()) {
+                stopped = true;
+                reason = SolveResult::Cancelled;
+            } else if ((limits->maxNodes > 0 && nodes > limits->maxNodes)
+                       || SearchLimits::Clock::now() >= limits->deadline) {
+                stopped = true;
+                reason = SolveResult::TimedOut;
+            }
+        }
+        if (stopped) return true;
+
+        nextCheck = nodes + CHECK_INTERVAL;
+        if (limits->maxNodes > 0) nextCheck = std::min(nextCheck, limits->maxNodes + 1);
+        return false;
+    }
+
+public:
+    static constexpr long CHECK_INTERVAL = 1024;
+
+    // A budget that never runs out if limits is null. limits must outlive
+    // the budget.
+    explicit SearchBudget(const SearchLimits *limits = nullptr)
+        : limits(limits)
+        , nextCheck(limits ? 0 : std::numeric_limits<long>::max()) {}
+
+    // Counts a node. Returns true if the search should stop. Keeps
+    // returning true once the search is stopped, so every level of a
+    // search can unwind.
+    inline bool spend() {
+        if (++nodes < nextCheck) return false;
+        return check();
+    }
+
+    inline bool isStopped() const {
+        return stopped;
+    }
+
+    // Returns TimedOut or Cancelled.
+    // requires: isStopped()
+    inline SolveResult getReason() const {
+        return reason;
+    }
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+
+// Search statistics are only collected if SUDOKU_STATS is defined, with
+// cmake -DSUDOKU_STATS=ON. Otherwise every counter and timer compiles to
+// nothing, and the stats are always zero.
+#ifdef SUDOKU_STATS
+constexpr bool STATS_ENABLED = true;
+#else
+constexpr bool STATS_ENABLED = false;
+#endif
+
+// SearchStats counts the work done by one search, to tell why a puzzle is
+// slow.
+struct SearchStats {
+    // Number of values tried, including the ones that failed right away.
+    long nodes = 0;
+
+    // Number of times every value of a cell failed and the search went back
+    // to the previous cell.
+    long backtracks = 0;
+
+    // Number of those backtracks that skipped cells, since the assignments
+    // of the cells skipped didn't cause any of the failures.
+    long backjumps = 0;
+
+    // Most cells assigned by the search at once, not counting the cells
+    // assigned by inferences.
+    int maxDepth = 0;
+
+    // Number of possible values removed by forward checking.
+    long valuesPruned = 0;
+
+    // Number of cells assigned and possible values removed by inferences.
+    long valuesPropagated = 0;
+
+    // Time spent choosing the next cell and ordering its values.
+    std::chrono::nanoseconds varOrderingTime{0};
+    std::chrono::nanoseconds valueOrderingTime{0};
+
+    // Adds the counts of other, and keeps the larger max depth.
+    SearchStats& operator+=(const SearchStats &other) {
+        nodes += other.nodes;
+        backtracks += other.backtracks;
+        backjumps += other.backjumps;
+        if (other.maxDepth > maxDepth) maxDepth = other.maxDepth;
+        valuesPruned += other.valuesPruned;
+        valuesPropagated += other.valuesPropagated;
+        varOrderingTime += other.varOrderingTime;
+        valueOrderingTime += other.valueOrderingTime;
+        return *this;
+    }
+};
+
+// StatsTimer adds the time from its construction to its destruction to a
+// duration of SearchStats. Does nothing if stats aren't enabled.
+class StatsTimer {
+    std::chrono::nanoseconds &total;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit StatsTimer(std::chrono::nanoseconds &total) : total(total) {
+        if constexpr (STATS_ENABLED) start = std::chrono::steady_clock::now();
+    }
+
+    ~StatsTimer() {
+        if constexpr (STATS_ENABLED) total += std::chrono::steady_clock::now() - start;
+    }
+
+    StatsTimer(const StatsTimer&) = delete;
+    StatsTimer& operator=(const StatsTimer&) = delete;
+};
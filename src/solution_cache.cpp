@@ -0,0 +1,207 @@
+#include "solution_cache.h"
+#include <stdexcept>
+#include "sudoku_io.h"
+
+using namespace std;
+
+namespace {
+    // Returns cells, one char per cell value, as symbols.
+    string toSymbols(const string &cells) {
+        string symbols;
+        for (char c : cells) symbols.push_back(valueSymbol(c));
+        return symbols;
+    }
+}
+
+template <int N>
+BasicSolutionCache<N>::BasicSolutionCache(size_t capacity) : capacity(capacity) {
+    assert(capacity > 0);
+}
+
+template <int N>
+bool BasicSolutionCache<N>::find(const string &key, string &solution) {
+    lock_guard<std::mutex> lock(mutex);
+
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        ++numMisses;
+        return false;
+    }
+
+    // Move to the front of the recently used puzzles
+    recent.splice(recent.begin(), recent, it->second.position);
+    solution = it->second.solution;
+    ++numHits;
+    return true;
+}
+
+template <int N>
+void BasicSolutionCache<N>::insert(const string &key, const string &solution) {
+    lock_guard<std::mutex> lock(mutex);
+
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        recent.splice(recent.begin(), recent, it->second.position);
+        it->second.solution = solution;
+        return;
+    }
+
+    // Forget the least recently used puzzle if full
+    if (entries.size() >= capacity) {
+        entries.erase(recent.back());
+        recent.pop_back();
+    }
+
+    recent.push_front(key);
+    entries.emplace(key, Entry{solution, recent.begin()});
+}
+
+template <int N>
+void BasicSolutionCache<N>::load(istream &in) {
+    string line;
+    int lineNumber = 0;
+
+    while (getline(in, line)) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        size_t space = line.find(' ');
+        string puzzle = line.substr(0, space);
+        string answer = space == string::npos ? "" : line.substr(space + 1);
+
+        // Puzzles without a solution can't be checked without a search, so
+        // they're searched again instead. Files of older versions have them.
+        if (answer == "unsolvable" && puzzle.size() == static_cast<size_t>(NUM_CELLS)) {
+            continue;
+        }
+        if (puzzle.size() != static_cast<size_t>(NUM_CELLS)
+            || answer.size() != static_cast<size_t>(NUM_CELLS)) {
+            throw runtime_error("Cache line " + to_string(lineNumber)
+                                + " doesn't have a puzzle and a solution of "
+                                + to_string(NUM_CELLS) + " cells");
+        }
+
+        // Check the solution, so a damaged file can't give wrong answers
+        string key(NUM_CELLS, '\0');
+        string solution;
+        BasicSudoku<N> board;
+        bool valid = true;
+        for (int i=0; i<NUM_CELLS; ++i) {
+            int value = symbolValue(puzzle[i]);
+            int solved = symbolValue(answer[i]);
+            if (value < 0 || value > SIZE || solved <= 0 || solved > SIZE
+                || (value != 0 && value != solved)) {
+                valid = false;
+                break;
+            }
+            key[i] = static_cast<char>(value);
+            solution.push_back(static_cast<char>(solved));
+            board.setCell(i % SIZE, i / SIZE, solved);
+        }
+        if (!valid || !board.isSolved()) {
+            throw runtime_error("Cache line " + to_string(lineNumber)
+                                + " doesn't have a valid solution");
+        }
+
+        insert(key, solution);
+    }
+}
+
+template <int N>
+void BasicSolutionCache<N>::save(ostream &out) const {
+    lock_guard<std::mutex> lock(mutex);
+
+    for (auto it = recent.rbegin(); it != recent.rend(); ++it) {
+        const string &solution = entries.at(*it).solution;
+        if (!solution.empty()) out << toSymbols(*it) << ' ' << toSymbols(solution) << '\n';
+    }
+}
+
+template <int N>
+size_t BasicSolutionCache<N>::size() const {
+    lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+template <int N>
+long BasicSolutionCache<N>::getNumHits() const {
+    lock_guard<std::mutex> lock(mutex);
+    return numHits;
+}
+
+template <int N>
+long BasicSolutionCache<N>::getNumMisses() const {
+    lock_guard<std::mutex> lock(mutex);
+    return numMisses;
+}
+
+template <int N>
+BasicCachedSolver<N>::BasicCachedSolver(unique_ptr<BasicSudokuSolver<N>> solver
+                                        , shared_ptr<BasicSolutionCache<N>> cache)
+    : solver(move(solver)), cache(move(cache)) {}
+
+template <int N>
+bool BasicCachedSolver<N>::solve(BasicSudoku<N>& board) {
+    return solveWithin(board, SearchLimits()) == SolveResult::Solved;
+}
+
+template <int N>
+SolveResult BasicCachedSolver<N>::solveWithin(BasicSudoku<N>& board
+                                             , const SearchLimits &limits) {
+    lastHit = false;
+
+    // Puzzles breaking a rule aren't cached
+    if (!canonical.compute(board)) return solver->solveWithin(board, limits);
+
+    if (cache->find(canonical.getKey(), solution)) {
+        lastHit = true;
+        if (solution.empty()) return SolveResult::Unsolvable;
+
+        canonical.fromCanonical(solution, board);
+        return SolveResult::Solved;
+    }
+
+    // Searches that gave up aren't cached, since they may finish next time
+    SolveResult result = solver->solveWithin(board, limits);
+    if (result == SolveResult::Solved) {
+        canonical.toCanonical(board, solution);
+    } else if (result == SolveResult::Unsolvable) {
+        solution.clear();
+    } else {
+        return result;
+    }
+    cache->insert(canonical.getKey(), solution);
+    return result;
+}
+
+template <int N>
+int BasicCachedSolver<N>::countSolutions(BasicSudoku<N>& board, int limit) {
+    lastHit = false;
+    return solver->countSolutions(board, limit);
+}
+
+template <int N>
+CountResult BasicCachedSolver<N>::countWithin(BasicSudoku<N>& board, int limit
+                                              , const SearchLimits &limits) {
+    lastHit = false;
+    return solver->countWithin(board, limit, limits);
+}
+
+template <int N>
+unique_ptr<BasicSudokuSolver<N>> BasicCachedSolver<N>::clone() const {
+    return make_unique<BasicCachedSolver>(solver->clone(), cache);
+}
+
+template <int N>
+SearchStats BasicCachedSolver<N>::getStats() const {
+    return lastHit ? SearchStats() : solver->getStats();
+}
+
+template class BasicSolutionCache<3>;
+template class BasicSolutionCache<4>;
+template class BasicSolutionCache<5>;
+
+template class BasicCachedSolver<3>;
+template class BasicCachedSolver<4>;
+template class BasicCachedSolver<5>;
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include "sudoku_canonical.h"
+#include "sudoku_solver.h"
+
+// BasicSolutionCache remembers the solutions of the most recently solved
+// sudoku puzzles with N by N boxes, keyed by their canonical form, see
+// BasicCanonicalForm. Puzzles that are relabelings or rearrangements of each
+// other share one entry. Holds at most capacity puzzles, and forgets the
+// least recently used puzzle when full. Safe to use from multiple threads.
+template <int N>
+class BasicSolutionCache {
+public:
+    static constexpr int SIZE = BasicSudoku<N>::SIZE;
+    static constexpr int NUM_CELLS = BasicSudoku<N>::NUM_CELLS;
+
+private:
+    struct Entry {
+        // Canonical solution, or empty if the puzzle has no solution.
+        std::string solution;
+        std::list<std::string>::iterator position;
+    };
+
+    mutable std::mutex mutex;
+    std::size_t capacity;
+
+    // Keys from the most recently used to the least recently used.
+    std::list<std::string> recent;
+    std::unordered_map<std::string, Entry> entries;
+
+    long numHits = 0;
+    long numMisses = 0;
+
+public:
+    explicit BasicSolutionCache(std::size_t capacity);
+
+    // Looks up the canonical puzzle key. Returns true and stores its
+    // canonical solution in solution if it's cached, false otherwise. The
+    // solution is empty if the puzzle has no solution.
+    // effects: solution may change
+    bool find(const std::string &key, std::string &solution);
+
+    // Caches the canonical solution of the canonical puzzle key, or an empty
+    // solution if the puzzle has no solution.
+    // requires: key and solution have one char per cell value, see
+    //           BasicCanonicalForm
+    void insert(const std::string &key, const std::string &solution);
+
+    // Reads puzzles written by save, and adds them to the cache, keeping the
+    // order they were used in. Every solution is checked against its puzzle,
+    // so a damaged file can't give wrong answers, and lines of puzzles
+    // marked "unsolvable" are skipped, since that can't be checked without
+    // a search. Throws runtime_error if a line is malformed, or its solution
+    // doesn't solve its puzzle.
+    // effects: reads from in
+    void load(std::istream &in);
+
+    // Writes the cached puzzles with a solution to out, one per line, from
+    // the least recently used to the most recently used. Every line is the
+    // canonical puzzle and its solution, as symbols, see symbolValue.
+    // Puzzles without a solution aren't saved, see load.
+    // effects: writes to out
+    void save(std::ostream &out) const;
+
+    // Returns the number of cached puzzles.
+    std::size_t size() const;
+
+    // Returns the number of lookups that found a puzzle and that didn't.
+    long getNumHits() const;
+    long getNumMisses() const;
+};
+
+// BasicCachedSolver solves puzzles with another solver, but first looks for
+// them in a cache, and caches the puzzles it solves. A cached puzzle isn't
+// searched at all: its canonical solution is moved back to the puzzle.
+// Counting solutions isn't cached. Clones share the cache.
+template <int N>
+class BasicCachedSolver : public BasicSudokuSolver<N> {
+    std::unique_ptr<BasicSudokuSolver<N>> solver;
+    std::shared_ptr<BasicSolutionCache<N>> cache;
+
+    // Working memory reused between puzzles
+    BasicCanonicalForm<N> canonical;
+    std::string solution;
+
+    // True if the last puzzle was found in the cache.
+    bool lastHit = false;
+
+public:
+    BasicCachedSolver(std::unique_ptr<BasicSudokuSolver<N>> solver
+                      , std::shared_ptr<BasicSolutionCache<N>> cache);
+
+    bool solve(BasicSudoku<N>& board) override;
+
+    // Same as solve, but gives up once limits are reached, see
+    // BasicSudokuSolver::solveWithin. Searches that give up aren't cached.
+    // effects: board may change
+    SolveResult solveWithin(BasicSudoku<N>& board, const SearchLimits &limits) override;
+
+    int countSolutions(BasicSudoku<N>& board, int limit) override;
+
+    // Counts with the wrapped solver, see BasicSudokuSolver::countWithin.
+    // Counts aren't cached.
+    // effects: board may change
+    CountResult countWithin(BasicSudoku<N>& board, int limit
+                            , const SearchLimits &limits) override;
+
+    std::unique_ptr<BasicSudokuSolver<N>> clone() const override;
+
+    // Returns the stats of the last search, or zero stats if the last
+    // puzzle was found in the cache.
+    SearchStats getStats() const override;
+};
+
+// Caches solutions of 9x9 sudoku.
+using SolutionCache = BasicSolutionCache<3>;
+using CachedSolver = BasicCachedSolver<3>;
@@ -1,155 +1,173 @@
-#include "sudoku.h"
-#include <algorithm>
-
-using namespace std;
-
-Sudoku::Sudoku() : numEmptyCells(9*9) {
-    // Set state to contain all zeros
-    for (auto it = state.begin(); it != state.end(); ++it) {
-        for (auto it2 = it->begin(); it2 != it->end(); ++it2) {
-            *it2 = 0;
-        }
-    }
-
-    // Set possible values to contain all values from 1 to 9
-    for (auto it = values.begin(); it != values.end(); ++it) {
-        for (auto it2 = it->begin(); it2 != it->end(); ++it2) {
-            for (int i=1; i<=9; ++i) {
-                it2->push_back(i);
-            }
-        }
-    }
-}
-
-bool Sudoku::isConsistent(int x, int y, int value) const {
-    if (value == 0) return true;
-
-    // If cells along the same row and column contain value, failure
-    for (int i=0; i<9; ++i) {
-        if (i != x && state[i][y] == value) return false;
-        if (i != y && state[x][i] == value) return false;
-    }
-
-    // Check 3x3 subgrid
-    for (int i = x/3*3; i < x/3*3 + 3; ++i) {
-        for (int j = y/3*3; j < y/3*3 + 3; ++j) {
-            if (state[i][j] == value && (i != x || j != y)) return false;
-        }
-    }
-
-    // All constraints passed
-    return true;
-}
-
-bool Sudoku::isSolved() const {
-    // Do an easy check first before complete check
-    if (getNumEmptyCells() != 0) return false;
-
-    // Maintain visited digits for the rows, columns, and 3x3 subgrids.
-    // That is, rowNums[i][n] states whether row i contains the digit n.
-    bool rowNums[9][9]{}; // Default initialize to false
-    bool colNums[9][9]{};
-    bool subgridNums[3][3][9]{};
-
-    // Single pass through every cell, flagging the seen digits. If a digit
-    // was already seen, then board state is invalid. Otherwise, board state
-    // is a valid solution.
-    int n;
-    for(int row=0; row<9; ++row){
-        for(int col=0; col<9; ++col){
-
-            n = state[row][col]-1;
-            if (n <= -1) continue;
-
-            if (rowNums[row][n] || colNums[col][n]
-                || subgridNums[row/3][col/3][n])
-                return false;
-
-            rowNums[row][n] = true;
-            colNums[col][n] = true;
-            subgridNums[row/3][col/3][n] = true;
-        }
-    }
-
-    return true;
-}
-
-bool Sudoku::isPossibleValue(int x, int y, int value) const {
-    assertCell(x, y, value);
-
-    if (find(values[x][y].begin(), values[x][y].end(), value) != values[x][y].end()) {
-        return true;
-    }
-    return false;
-}
-
-void Sudoku::initCell(int x, int y, int value) {
-    assertCell(x, y, value);
-
-    setCell(x, y, value);
-
-    // Remove inconsistent possible values
-    int minX = x/3*3;
-    int minY = y/3*3;
-
-    // Remove inconsistent values from same 3x3 subgrid
-    for (int i = minX; i < minX+3; ++i) {
-        for (int j = minY; j < minY+3; ++j) {
-            values[i][j].remove(value);
-        }
-    }
-
-    // Remove inconsistent values from same row, excluding the already
-    // counted 3x3 subgrid.
-    for (int i=0; i<minX; ++i) {
-        values[i][y].remove(value);
-    }
-    for (int i=minX+3; i<9; ++i) {
-        values[i][y].remove(value);
-    }
-
-    // From same column
-    for (int j=0; j<minY; ++j) {
-        values[x][j].remove(value);
-    }
-    for (int j=minY+3; j<9; ++j) {
-        values[x][j].remove(value);
-    }
-}
-
-void Sudoku::setCell(int x, int y, int value) {
-    assertCell(x, y, value);
-
-    if (value != 0 && state[x][y] == 0) {
-        --numEmptyCells;
-    } else if (value == 0 && state[x][y] != 0) {
-        ++numEmptyCells;
-    }
-
-    state[x][y] = value;
-}
-
-bool Sudoku::addValue(int x, int y, int value) {
-    assertCell(x, y, value);
-
-    // If values[x][y] doesn't contain value
-    if (find(values[x][y].begin(), values[x][y].end(), value)
-        == values[x][y].end()) {
-
-        // Add it
-        values[x][y].push_back(value);
-        return true;
-    }
-    return false;
-}
-
-bool Sudoku::removeValue(int x, int y, int value) {
-    assertCell(x, y, value);
-
-    auto iter = find(values[x][y].begin(), values[x][y].end(), value);
-    if (iter != values[x][y].end()) {
-        values[x][y].erase(iter);
-        return true;
-    }
-    return false;
-}
+#include "sudoku.h"
+#include <algorithm>
+
+using namespace std;
+
+template <int N>
+BasicSudoku<N>::BasicSudoku() : numEmptyCells(NUM_CELLS), numConflicts(0) {
+    // Set state to contain all zeros, and the padding to filled cells
+    state.fill(1);
+    fill(state.begin(), state.begin() + NUM_CELLS, 0);
+
+    // Set possible values to contain all values from 1 to SIZE
+    values.fill(0);
+    fill(values.begin(), values.begin() + NUM_CELLS, ALL_VALUES);
+
+    unitValues.fill(0);
+    fillBuckets();
+}
+
+template <int N>
+void BasicSudoku<N>::fillBuckets() {
+    useBuckets = !(HAS_SIMD && simd::enabled());
+    if (!useBuckets) return;
+
+    for (auto &bucket : buckets) bucket.fill(0);
+
+    for (int cell=0; cell<NUM_CELLS; ++cell) {
+        if (state[cell] == 0) addToBucket(cell, countValues(values[cell]));
+    }
+}
+
+template <int N>
+bool BasicSudoku<N>::hasPeerWith(int cell, int value) const {
+    assertCell(cell, value);
+
+    for (CellIndex peer : Tables::PEERS[cell]) {
+        if (state[peer] == value) return true;
+    }
+    return false;
+}
+
+template <int N>
+void BasicSudoku<N>::removeConflictingUsed(int cell, int value) {
+    const Mask bit = valueBit<Mask>(value);
+    for (int unit : Tables::CELL_UNITS[cell]) {
+        bool others = false;
+        for (CellIndex other : Tables::UNITS[unit]) {
+            others = others || state[other] == value;
+        }
+
+        if (others) {
+            --numConflicts;
+        } else {
+            unitValues[unit] &= static_cast<Mask>(~bit);
+        }
+    }
+}
+
+template <int N>
+int BasicSudoku<N>::getFewestValuesCells(array<int, NUM_CELLS> &cells) const {
+    assert(getNumEmptyCells() > 0);
+
+    if (useBuckets) {
+        // The first bucket with a cell
+        for (const auto &bucket : buckets) {
+            int size = 0;
+            for (int i=0; i<BUCKET_WORDS; ++i) {
+                for (uint32_t bits = bucket[i]; bits != 0; bits &= bits - 1) {
+                    cells[size++] = i * 32 + lowestValue(bits) - 1;
+                }
+            }
+            if (size > 0) return size;
+        }
+
+        assert(false);
+        return 0;
+    }
+
+#if SUDOKU_SIMD
+    if constexpr (HAS_SIMD) {
+        if (simd::enabled()) {
+            constexpr int NUM_WORDS = NUM_LANES / simd::LANES;
+            array<uint16_t, NUM_WORDS> fewest;
+            simd::findFewestValues(state.data(), values.data(), NUM_LANES
+                                   , fewest.data());
+
+            int size = 0;
+            for (int i=0; i<NUM_WORDS; ++i) {
+                for (unsigned bits = fewest[i]; bits != 0; bits &= bits - 1) {
+                    cells[size++] = i * simd::LANES + lowestValue(bits) - 1;
+                }
+            }
+            return size;
+        }
+    }
+#endif
+
+    int minValues = SIZE + 1;
+    int size = 0;
+    for (int cell=0; cell<NUM_CELLS; ++cell) {
+        if (state[cell] != 0) continue;
+
+        int numValues = countValues(values[cell]);
+        if (numValues < minValues) {
+            size = 0;
+            minValues = numValues;
+        }
+        if (numValues == minValues) {
+            cells[size++] = cell;
+        }
+    }
+    return size;
+}
+
+template <int N>
+void BasicSudoku<N>::initCell(int x, int y, int value) {
+    assertLocation(x, y, value);
+
+    int cell = cellIndex(x, y);
+    setCell(cell, value);
+
+    if (value == 0) return;
+
+    // Remove inconsistent possible values from the cells in the same row,
+    // column, and NxN subgrid
+    for (CellIndex peer : Tables::PEERS[cell]) {
+        removeValue(peer, value);
+    }
+    removeValue(cell, value);
+}
+
+template <int N>
+void BasicSudoku<N>::loadCells(const uint8_t *cells) {
+    numEmptyCells = NUM_CELLS;
+    unitValues.fill(0);
+    numConflicts = 0;
+
+    for (int y=0; y<SIZE; ++y) {
+        for (int x=0; x<SIZE; ++x) {
+            int cell = cellIndex(x, y);
+            int value = cells[y*SIZE + x];
+            assertCell(cell, value);
+
+            state[cell] = static_cast<uint8_t>(value);
+            if (value == 0) continue;
+
+            addUsed(cell, value);
+            --numEmptyCells;
+        }
+    }
+
+    // A cell can take the values not used in its row, column, or box
+    for (int cell=0; cell<NUM_CELLS; ++cell) {
+        const auto &units = Tables::CELL_UNITS[cell];
+        const Mask used = unitValues[units[0]] | unitValues[units[1]]
+                          | unitValues[units[2]];
+        values[cell] = static_cast<Mask>(ALL_VALUES & ~used);
+    }
+    fillBuckets();
+}
+
+template <int N>
+void BasicSudoku<N>::storeCells(uint8_t *cells) const {
+    for (int y=0; y<SIZE; ++y) {
+        for (int x=0; x<SIZE; ++x) {
+            cells[y*SIZE + x] = state[cellIndex(x, y)];
+        }
+    }
+}
+
+template class BasicSudoku<3>;
+template class BasicSudoku<4>;
+template class BasicSudoku<5>;
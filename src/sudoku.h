@@ -1,114 +1,520 @@
-#pragma once
-
-#include <cassert>
-#include <algorithm>
-#include <list>
-#include <array>
-
-// Sudoku is a puzzle game. The objective is to fill out a 9 by 9 grid
-// with numbers ranging from 1 to 9 so that no row, column, or smaller
-// 3x3 grid has a repeating digit. A sudoku puzzle initially has some
-// cells filled. The player then fills the rest. For more info, see
-// https://en.wikipedia.org/wiki/Sudoku
-
-// Sudoku class implements a sudoku board, along with some helpful members
-// and functions useful for backtracking, like possible values each cell
-// can take on and functions to add or remove possible vaues.
-// Sudoku uses coordinates (0, 0) for the top left cell, (8, 0) for the top
-// right cell.
-class Sudoku {
-    // State represents a (partially) filled 9x9 sudoku board. state[0][0]
-    // is the top left cell, and state[8][0] is the top right cell. A cell
-    // with a value of zero means it's empty/unfilled. Otherwise, cells have
-    // integer values ranging from 1 to 9.
-    std::array<std::array<int, 9>, 9> state;
-
-    // A 9x9 array where each element is a list. Each list stores the values
-    // that its cell can take, according to the current inferences. Values
-    // range from 1 to 9. Manipulated by SudukuBacktrack class.
-    std::array<std::array<std::list<int>, 9>, 9> values;
-
-    int numEmptyCells;
-
-    // Asserts that (x, y) is a valid cell location and value is a valid digit.
-    inline void assertCell(int x, int y, int value=0) const {
-        assert(0 <= x && x <= 8 && 0 <= y && y <= 8
-               && value >= 0 && value <= 9);
-    }
-public:
-    Sudoku();
-
-    // Returns true if placing value at cell (x, y) doesn't violate any
-    // sudoku rules in the current board state.
-    // requires: 0 <= x <= 8
-    //           0 <= y <= 8
-    //           0 <= value <= 9
-    bool isConsistent(int x, int y, int value) const;
-
-    // Returns true if board state is a valid sudoku solution.
-    bool isSolved() const;
-
-    // Returns true if values[x][y] contains value. False otherwise.
-    // requires: 0 <= x <= 8
-    //           0 <= y <= 8
-    //           0 <= value <= 9
-    bool isPossibleValue(int x, int y, int value) const;
-
-    // Returns true if cell (x, y0 is unfilled. False otherwise.
-    inline bool isEmpty(int x, int y) const {
-        return (getCell(x, y) == 0);
-    }
-
-    // Getters
-    // Get number of empty cells in current board state
-    inline int getNumEmptyCells() const {
-        return numEmptyCells;
-    }
-
-    // Get value at cell (x, y)
-    // requires: 0 <= x <= 8
-    //           0 <= y <= 8
-    inline int getCell(int x, int y) const {
-        assertCell(x, y);
-        return state[x][y];
-    };
-
-    // Returns a constant reference to the board state.
-    inline const std::array<std::array<int, 9>, 9>& getState() const {
-        return state;
-    };
-
-    // Returns a constant reference to the possible values of cell (x, y).
-    // requires: 0 <= x <= 8
-    //           0 <= y <= 8
-    inline const std::list<int>& getValues(int x, int y) const {
-        return values[x][y];
-    }
-
-    // Sets the value of cell (x, y). Also removes inconsistent possible
-    // values from other cells.
-    // requires: 0 <= x <= 8
-    //           0 <= y <= 8
-    //           0 <= value <= 9
-    void initCell(int x, int y, int value);
-
-    // Sets the value of cell (x, y).
-    // requires: 0 <= x <= 8
-    //           0 <= y <= 8
-    //           0 <= value <= 9
-    void setCell(int x, int y, int value);
-
-    // Adds value to values at cell (x, y) if it wasn't there before.
-    // Returns true if value was added, false otherwise.
-    // requires: 0 <= x <= 8
-    //           0 <= y <= 8
-    //           0 <= value <= 9
-    bool addValue(int x, int y, int value);
-
-    // Removes value from values at cell (x, y) if it's currently there.
-    // Returns true if value was removed, false otherwise.
-    // requires: 0 <= x <= 8
-    //           0 <= y <= 8
-    //           0 <= value <= 9
-    bool removeValue(int x, int y, int value);
-};
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <algorithm>
+#include <array>
+#include <type_traits>
+#include "sudoku_simd.h"
+#include "sudoku_tables.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Sudoku is a puzzle game. The objective is to fill out a 9 by 9 grid
+// with numbers ranging from 1 to 9 so that no row, column, or smaller
+// 3x3 grid has a repeating digit. A sudoku puzzle initially has some
+// cells filled. The player then fills the rest. For more info, see
+// https://en.wikipedia.org/wiki/Sudoku
+//
+// Larger variants use N*N by N*N grids of N by N boxes, with numbers from 1
+// to N*N. ex. 16x16 sudoku has 4x4 boxes and numbers from 1 to 16. The box
+// size N is a template parameter, so every size gets fixed size storage and
+// loops, and the common 9x9 sudoku is BasicSudoku<3>.
+
+// Returns true if sudoku with N by N boxes are supported, for 9x9, 16x16
+// and 25x25 sudoku.
+template <int N>
+constexpr bool isSupportedBoxSize() {
+    return N >= 3 && N <= 5;
+}
+
+// A mask with one bit per value of an N*N by N*N sudoku.
+template <int N>
+using MaskType = std::conditional_t<(N*N <= 16), std::uint16_t, std::uint32_t>;
+
+// ValueMask is a set of cell values stored as a bitmask. Bit (v - 1) is set
+// if value v is in the set. ex. 0x1FF holds all values from 1 to 9.
+using ValueMask = MaskType<3>;
+
+// Mask holding every value from 1 to 9.
+const ValueMask ALL_VALUES = 0x1FF;
+
+// Returns the mask of type Mask containing only value.
+// requires: 1 <= value <= number of bits of Mask
+template <typename Mask = ValueMask>
+inline Mask valueBit(int value) {
+    return static_cast<Mask>(1u << (value - 1));
+}
+
+// Returns the number of values in mask.
+inline int countValues(std::uint32_t mask) {
+#if defined(_MSC_VER)
+    return __popcnt(mask);
+#else
+    return __builtin_popcount(mask);
+#endif
+}
+
+// Returns the smallest value in mask.
+// requires: mask != 0
+inline int lowestValue(std::uint32_t mask) {
+    assert(mask != 0);
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index) + 1;
+#else
+    return __builtin_ctz(mask) + 1;
+#endif
+}
+
+// BasicSudoku class implements a sudoku board with N by N boxes, along with
+// some helpful members and functions useful for backtracking, like possible
+// values each cell can take on and functions to add or remove possible
+// vaues. BasicSudoku uses coordinates (0, 0) for the top left cell,
+// (SIZE - 1, 0) for the top right cell.
+// requires: isSupportedBoxSize<N>()
+template <int N>
+class BasicSudoku {
+    static_assert(isSupportedBoxSize<N>(), "Box size must be 3, 4 or 5");
+
+public:
+    // Width and height of a box, and of the whole board.
+    static constexpr int BOX = N;
+    static constexpr int SIZE = N * N;
+    static constexpr int NUM_CELLS = SIZE * SIZE;
+
+    // Length of the board arrays, NUM_CELLS rounded up to whole vectors.
+    // The cells past NUM_CELLS are padding, always filled and without
+    // possible values.
+    static constexpr int NUM_LANES = numLanes<N>();
+
+    using Mask = MaskType<N>;
+    using Tables = SudokuTables<N>;
+
+    // Mask holding every value from 1 to SIZE.
+    static constexpr Mask ALL_VALUES = static_cast<Mask>((1ull << SIZE) - 1);
+
+private:
+    // True if the whole board scans can use the vectorized routines, which
+    // work on 16 bit masks.
+    static constexpr bool HAS_SIMD = SUDOKU_SIMD && sizeof(Mask) == 2;
+
+    // State represents a (partially) filled sudoku board, one cell after
+    // another, column by column. state[0] is the top left cell, and
+    // state[SIZE-1] is the bottom left cell. A cell with a value of zero means it's
+    // empty/unfilled. Otherwise, cells have integer values ranging from 1 to
+    // SIZE.
+    std::array<std::uint8_t, NUM_LANES> state;
+
+    // A bitmask for every cell, in the same order as state. Each mask stores
+    // the values that its cell can take, according to the current
+    // inferences. Values range from 1 to SIZE. Manipulated by SudukuBacktrack
+    // class.
+    std::array<Mask, NUM_LANES> values;
+
+    int numEmptyCells;
+
+    // The values used in every unit, numbered as in Tables::UNITS. A value is
+    // used if any cell of the unit has it.
+    std::array<Mask, Tables::NUM_UNITS> unitValues;
+
+    // Number of times a value is in a unit that already had it, so 0 unless
+    // the board breaks the rules. Only boards with conflicts have to look
+    // at the cells of a unit to keep unitValues exact.
+    int numConflicts;
+
+    // Adds value at cell to the used values of its units.
+    // requires: 1 <= value <= SIZE
+    inline void addUsed(int cell, int value) {
+        const Mask bit = valueBit<Mask>(value);
+        for (int unit : Tables::CELL_UNITS[cell]) {
+            if ((unitValues[unit] & bit) != 0) {
+                ++numConflicts;
+            } else {
+                unitValues[unit] |= bit;
+            }
+        }
+    }
+
+    // Removes value, which cell no longer has, from the used values of its
+    // units.
+    // requires: 1 <= value <= SIZE
+    inline void removeUsed(int cell, int value) {
+        if (numConflicts > 0) {
+            removeConflictingUsed(cell, value);
+            return;
+        }
+        const Mask keep = static_cast<Mask>(~valueBit<Mask>(value));
+        for (int unit : Tables::CELL_UNITS[cell]) {
+            unitValues[unit] &= keep;
+        }
+    }
+
+    // Same as removeUsed, but keeps value in the units where another cell
+    // has it.
+    void removeConflictingUsed(int cell, int value);
+
+    // The empty cells by their number of possible values, for the minimum
+    // remaining values heuristic, so the cells with the fewest values are
+    // found without scanning the board. Bit i of word w of buckets[k] is set
+    // if cell 32*w + i is empty and has k possible values.
+    // Only kept if useBuckets. The vectorized scan of 16 bit masks is
+    // faster than moving a bucket bit for every removed value.
+    static constexpr int BUCKET_WORDS = (NUM_CELLS + 31) / 32;
+    std::array<std::array<std::uint32_t, BUCKET_WORDS>, SIZE + 1> buckets;
+    bool useBuckets;
+
+    inline void addToBucket(int cell, int bucket) {
+        buckets[bucket][cell / 32] |= 1u << (cell % 32);
+    }
+
+    inline void removeFromBucket(int cell, int bucket) {
+        buckets[bucket][cell / 32] &= ~(1u << (cell % 32));
+    }
+
+    // Moves empty cell to the bucket of its number of possible values,
+    // after it gained or lost one value.
+    // requires: delta is 1 if cell gained a value, -1 if it lost one
+    inline void moveBucket(int cell, int delta) {
+        int numValues = countValues(values[cell]);
+        removeFromBucket(cell, numValues - delta);
+        addToBucket(cell, numValues);
+    }
+
+    // Picks whether to keep buckets, and if so, empties them and adds every
+    // empty cell to its bucket.
+    void fillBuckets();
+
+    // Asserts that cell is a valid cell number and value is a valid digit.
+    inline void assertCell(int cell, int value=0) const {
+        assert(0 <= cell && cell < NUM_CELLS && value >= 0 && value <= SIZE);
+        (void)cell; (void)value;
+    }
+
+    // Asserts that (x, y) is a valid cell location and value is a valid
+    // digit.
+    inline void assertLocation(int x, int y, int value=0) const {
+        assert(0 <= x && x < SIZE && 0 <= y && y < SIZE);
+        assertCell(cellIndex(x, y), value);
+    }
+public:
+    BasicSudoku();
+
+    // Returns the number of cell (x, y). Cells are numbered column by
+    // column, so cell 0 is the top left cell, and cell SIZE is the top cell
+    // of the second column.
+    static constexpr int cellIndex(int x, int y) {
+        return x * SIZE + y;
+    }
+
+    // Returns the x and y coordinates of cell.
+    static constexpr int cellX(int cell) {
+        return cell / SIZE;
+    }
+    static constexpr int cellY(int cell) {
+        return cell % SIZE;
+    }
+
+    // Returns true if placing value at cell doesn't violate any sudoku rules
+    // in the current board state.
+    // requires: 0 <= cell < NUM_CELLS
+    //           0 <= value <= SIZE
+    inline bool isConsistent(int cell, int value) const {
+        assertCell(cell, value);
+
+        if (value == 0) return true;
+
+        const auto &units = Tables::CELL_UNITS[cell];
+        const Mask used = unitValues[units[0]] | unitValues[units[1]]
+                          | unitValues[units[2]];
+        if ((used & valueBit<Mask>(value)) == 0) return true;
+
+        // A row, column, or box has value. If it isn't cell, it's a peer
+        if (state[cell] != value) return false;
+
+        // Otherwise, a peer also has value only if the board has conflicts
+        return numConflicts == 0 || !hasPeerWith(cell, value);
+    }
+
+    // Same as isConsistent(cellIndex(x, y), value).
+    inline bool isConsistent(int x, int y, int value) const {
+        return isConsistent(cellIndex(x, y), value);
+    }
+
+    // Returns true if board state is a valid sudoku solution.
+    inline bool isSolved() const {
+        // A full board without conflicts has every value once in every unit
+        return numEmptyCells == 0 && numConflicts == 0;
+    }
+
+    // Returns true if a cell in the same row, column, or NxN subgrid as cell
+    // has value.
+    // requires: 0 <= cell < NUM_CELLS
+    //           0 <= value <= SIZE
+    bool hasPeerWith(int cell, int value) const;
+
+    // Returns true if the possible values of cell contain value. False
+    // otherwise.
+    // requires: 0 <= cell < NUM_CELLS
+    //           0 <= value <= SIZE
+    inline bool isPossibleValue(int cell, int value) const {
+        assertCell(cell, value);
+        if (value == 0) return false;
+        return (values[cell] & valueBit<Mask>(value)) != 0;
+    }
+
+    // Returns true if the possible values of cell (x, y) contain value.
+    // False otherwise.
+    // requires: 0 <= x < SIZE
+    //           0 <= y < SIZE
+    //           0 <= value <= SIZE
+    inline bool isPossibleValue(int x, int y, int value) const {
+        assertLocation(x, y, value);
+        return isPossibleValue(cellIndex(x, y), value);
+    }
+
+    // Returns true if cell is unfilled. False otherwise.
+    inline bool isEmpty(int cell) const {
+        return (getCell(cell) == 0);
+    }
+
+    // Returns true if cell (x, y0 is unfilled. False otherwise.
+    inline bool isEmpty(int x, int y) const {
+        return (getCell(x, y) == 0);
+    }
+
+    // Getters
+    // Get number of empty cells in current board state
+    inline int getNumEmptyCells() const {
+        return numEmptyCells;
+    }
+
+    // Get value at cell
+    // requires: 0 <= cell < NUM_CELLS
+    inline int getCell(int cell) const {
+        assertCell(cell);
+        return state[cell];
+    }
+
+    // Get value at cell (x, y)
+    // requires: 0 <= x < SIZE
+    //           0 <= y < SIZE
+    inline int getCell(int x, int y) const {
+        assertLocation(x, y);
+        return state[cellIndex(x, y)];
+    };
+
+    // Returns a constant reference to the board state, with cell (x, y) at
+    // index cellIndex(x, y), followed by the padding.
+    inline const std::array<std::uint8_t, NUM_LANES>& getState() const {
+        return state;
+    };
+
+    // Returns the possible values of cell as a bitmask.
+    // requires: 0 <= cell < NUM_CELLS
+    inline Mask getValues(int cell) const {
+        assertCell(cell);
+        return values[cell];
+    }
+
+    // Returns the possible values of cell (x, y) as a bitmask.
+    // requires: 0 <= x < SIZE
+    //           0 <= y < SIZE
+    inline Mask getValues(int x, int y) const {
+        assertLocation(x, y);
+        return values[cellIndex(x, y)];
+    }
+
+    // Returns the number of possible values of cell.
+    // requires: 0 <= cell < NUM_CELLS
+    inline int getNumValues(int cell) const {
+        return countValues(getValues(cell));
+    }
+
+    // Returns the number of possible values of cell (x, y).
+    // requires: 0 <= x < SIZE
+    //           0 <= y < SIZE
+    inline int getNumValues(int x, int y) const {
+        return countValues(getValues(x, y));
+    }
+
+    // Sets the value of cell (x, y). Also removes inconsistent possible
+    // values from other cells.
+    // requires: 0 <= x < SIZE
+    //           0 <= y < SIZE
+    //           0 <= value <= SIZE
+    void initCell(int x, int y, int value);
+
+    // Replaces the whole board with cells, given row by row, so cell (x, y)
+    // is cells[y*SIZE + x], with 0 for empty cells. Same as initCell on a
+    // new board for every cell, but computes the possible values once per
+    // row, column, and box instead of once per filled cell.
+    // requires: cells has NUM_CELLS values from 0 to SIZE
+    void loadCells(const std::uint8_t *cells);
+
+    // Writes the board to cells row by row, in the order loadCells reads.
+    // requires: cells has room for NUM_CELLS values
+    void storeCells(std::uint8_t *cells) const;
+
+    // Sets the value of cell.
+    // requires: 0 <= cell < NUM_CELLS
+    //           0 <= value <= SIZE
+    inline void setCell(int cell, int value) {
+        assertCell(cell, value);
+
+        const int old = state[cell];
+        if (value == old) return;
+
+        state[cell] = static_cast<std::uint8_t>(value);
+        if (old != 0) {
+            removeUsed(cell, old);
+            ++numEmptyCells;
+        } else if (useBuckets) {
+            removeFromBucket(cell, countValues(values[cell]));
+        }
+        if (value != 0) {
+            addUsed(cell, value);
+            --numEmptyCells;
+        } else if (useBuckets) {
+            addToBucket(cell, countValues(values[cell]));
+        }
+    }
+
+    // Sets the value of cell (x, y).
+    // requires: 0 <= x < SIZE
+    //           0 <= y < SIZE
+    //           0 <= value <= SIZE
+    inline void setCell(int x, int y, int value) {
+        assertLocation(x, y, value);
+        setCell(cellIndex(x, y), value);
+    }
+
+    // Adds value to the possible values of cell if it wasn't there before.
+    // Returns true if value was added, false otherwise.
+    // requires: 0 <= cell < NUM_CELLS
+    //           0 <= value <= SIZE
+    inline bool addValue(int cell, int value) {
+        assertCell(cell, value);
+
+        if (value == 0) return false;
+
+        // If values[cell] doesn't contain value, add it
+        const Mask bit = valueBit<Mask>(value);
+        if ((values[cell] & bit) == 0) {
+            values[cell] |= bit;
+            if (useBuckets && state[cell] == 0) moveBucket(cell, 1);
+            return true;
+        }
+        return false;
+    }
+
+    // Adds value to values at cell (x, y) if it wasn't there before.
+    // Returns true if value was added, false otherwise.
+    // requires: 0 <= x < SIZE
+    //           0 <= y < SIZE
+    //           0 <= value <= SIZE
+    inline bool addValue(int x, int y, int value) {
+        assertLocation(x, y, value);
+        return addValue(cellIndex(x, y), value);
+    }
+
+    // Removes value from the possible values of cell if it's currently
+    // there. Returns true if value was removed, false otherwise.
+    // requires: 0 <= cell < NUM_CELLS
+    //           0 <= value <= SIZE
+    inline bool removeValue(int cell, int value) {
+        assertCell(cell, value);
+
+        if (value == 0) return false;
+
+        const Mask bit = valueBit<Mask>(value);
+        if ((values[cell] & bit) != 0) {
+            values[cell] &= static_cast<Mask>(~bit);
+            if (useBuckets && state[cell] == 0) moveBucket(cell, -1);
+            return true;
+        }
+        return false;
+    }
+
+    // Removes value from values at cell (x, y) if it's currently there.
+    // Returns true if value was removed, false otherwise.
+    // requires: 0 <= x < SIZE
+    //           0 <= y < SIZE
+    //           0 <= value <= SIZE
+    inline bool removeValue(int x, int y, int value) {
+        assertLocation(x, y, value);
+        return removeValue(cellIndex(x, y), value);
+    }
+
+    // Stores the empty cells with the fewest possible values in cells, in
+    // increasing order, and returns how many there are.
+    // requires: getNumEmptyCells() > 0
+    int getFewestValuesCells(std::array<int, NUM_CELLS> &cells) const;
+
+    // Returns the first empty cell with no possible values left, or -1 if
+    // there is none.
+    inline int findWipedOutCell() const {
+        if (!useBuckets) {
+            for (int cell=0; cell<NUM_CELLS; ++cell) {
+                if (state[cell] == 0 && values[cell] == 0) return cell;
+            }
+            return -1;
+        }
+        for (int i=0; i<BUCKET_WORDS; ++i) {
+            if (buckets[0][i] != 0) return i * 32 + lowestValue(buckets[0][i]) - 1;
+        }
+        return -1;
+    }
+
+    // Removes value from the possible values of the cells in the same row,
+    // column, and NxN subgrid as cell, and calls removed(peer) for every one
+    // of them that had value. Returns false if one of them is empty and has
+    // no possible values left, true otherwise. The other cells may be left
+    // unchanged on failure.
+    // requires: 0 <= cell < NUM_CELLS
+    //           1 <= value <= SIZE
+    template <typename Removed>
+    bool removeFromPeers(int cell, int value, Removed removed);
+};
+
+template <int N>
+template <typename Removed>
+bool BasicSudoku<N>::removeFromPeers(int cell, int value, Removed removed) {
+    assertCell(cell, value);
+
+#if SUDOKU_SIMD
+    if constexpr (HAS_SIMD) {
+        if (simd::enabled()) {
+            constexpr int NUM_WORDS = NUM_LANES / simd::LANES;
+            std::array<std::uint16_t, NUM_WORDS> removedCells;
+
+            bool success = simd::removeFromPeers(state.data(), values.data()
+                                                 , Tables::PEER_BITS[cell].data()
+                                                 , NUM_LANES, valueBit<Mask>(value)
+                                                 , removedCells.data());
+
+            for (int i=0; i<NUM_WORDS; ++i) {
+                for (unsigned bits = removedCells[i]; bits != 0; bits &= bits - 1) {
+                    int peer = i * simd::LANES + lowestValue(bits) - 1;
+                    if (useBuckets && state[peer] == 0) moveBucket(peer, -1);
+                    removed(peer);
+                }
+            }
+            return success;
+        }
+    }
+#endif
+
+    for (CellIndex peer : Tables::PEERS[cell]) {
+        if (removeValue(peer, value)) removed(peer);
+
+        if (state[peer] == 0 && values[peer] == 0) return false;
+    }
+    return true;
+}
+
+// The standard 9x9 sudoku.
+using Sudoku = BasicSudoku<3>;
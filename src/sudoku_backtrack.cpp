@@ -1,280 +1,1035 @@
-#include "sudoku_backtrack.h"
-using namespace std;
-
-array<int, 2> SudokuBacktrack::getNextVar(const Sudoku& board) const {
-    assert(board.getNumEmptyCells() > 0);
-
-    // If using minimum remaining values heuristic
-    if (heuristic == 3) {
-        int minValues = 9;
-        vector<array<int, 2>> leastVars;
-
-        // Find empty cells with least remaining possible values and return it
-        for (int i=0; i<9; ++i) {
-            for (int j=0; j<9; ++j) {
-                if (board.isEmpty(i, j)) {
-                    int size = board.getValues(i, j).size();
-
-                    if (size < minValues) {
-                        leastVars.clear();
-                        minValues = size;
-                    }
-                    if (size == minValues) {
-                        leastVars.push_back(array<int, 2>{i, j});
-                    }
-                }
-            }
-        }
-        if (leastVars.size() == 1) return leastVars.front();
-
-        int maxConstraints = -1;
-        array<int, 2> bestVar{-1, -1};
-
-        // If multiple cells, use most constraining variable as tiebreaker.
-        // For each cell in leastVars
-        for (const array<int, 2> &var : leastVars) {
-
-            int constraints = 0;
-
-            int x = var[0];
-            int y = var[1];
-            int minX = x/3*3;
-            int minY = y/3*3;
-
-            // Count number of empty cells in 3x3 subgrid
-            for (int i = minX; i < minX+3; ++i) {
-                for (int j = minY; j < minY+3; ++j) {
-                    if (i != x && j != y && board.isEmpty(i, j)) {
-                        ++constraints;
-                    }
-                }
-            }
-
-            // Count number of empty cells in row, excluding the 3x3 subgrid
-            // already counted
-            for (int i=0; i<minX; ++i) {
-                if (board.isEmpty(i, y)) ++constraints;
-            }
-            for (int i=minX+3; i<9; ++i) {
-                if (board.isEmpty(i, y)) ++constraints;
-            }
-
-            // Count number of empty cells in column
-            for (int j=0; j<minY; ++j) {
-                if (board.isEmpty(x, j)) ++constraints;
-            }
-            for (int j=minY+3; j<9; ++j) {
-                if (board.isEmpty(x, j)) ++constraints;
-            }
-
-            // Set bestVar to cell with most number of constraints
-            if (constraints > maxConstraints) {
-                maxConstraints = constraints;
-                bestVar = var;
-            }
-        } // End for each cell in leastVars
-
-        assert(bestVar[0] != -1);
-        return bestVar;
-    }
-    // Else, not using heuristic for getting next variable
-    else {
-        // Return any empty cell
-        for (int i=0; i<9; ++i) {
-            for (int j=0; j<9; ++j) {
-                if (board.isEmpty(i, j)) {
-                    return array<int, 2>{i, j};
-                }
-            }
-        }
-    }
-
-    // No empty cell found. Should never reach this point.
-    assert(false);
-    return array<int, 2>{0, 0};
-}
-
-list<int> SudokuBacktrack::getValues(const Sudoku& board, int x, int y) const {
-
-    // If using least constraining value heuristic
-    if (heuristic == 3) {
-        auto values = board.getValues(x, y);
-
-        // constraintPairs is a vector of pairs of numbers. First number of the pair is a
-        // value of cell (x, y), second number is the number of constraints for that value.
-        // ex. If the board is full, then the constraintPairs[i][1] = 0 for all i.
-        //     If cell (x, y) only has a possible value of 9, then constraintPairs[0][0] = 9.
-        //     In addition, if all other cells in the same row, column, and 3x3 subgrid are
-        //     filled except for one cell that also has a possible value of 9, then
-        //     constraintPairs[0][1] = 1.
-        vector<array<int, 2>> constraintPairs;
-        constraintPairs.reserve(values.size());
-
-        // For each possible value of cell (x, y)
-        for (int val : board.getValues(x, y)) {
-
-            int constraints = 0;
-            int minX = x/3*3;
-            int minY = y/3*3;
-
-            // Count number of empty cells in 3x3 subgrid that has the same
-            // possible value.
-            for (int i = minX; i < minX+3; ++i) {
-                for (int j = minY; j < minY+3; ++j) {
-                    if (i != x && j != y && board.isEmpty(i, j)
-                        && board.isPossibleValue(i, j, val)) {
-                        ++constraints;
-                    }
-                }
-            }
-
-            // Count number of empty cells in row that has the same possible
-            // value, excluding the 3x3 subgrid already counted
-            for (int i=0; i<minX; ++i) {
-                if (board.isEmpty(i, y) && board.isPossibleValue(i, y, val))
-                    ++constraints;
-            }
-            for (int i=minX+3; i<9; ++i) {
-                if (board.isEmpty(i, y) && board.isPossibleValue(i, y, val))
-                    ++constraints;
-            }
-
-            // Count in column
-            for (int j=0; j<minY; ++j) {
-                if (board.isEmpty(x, j) && board.isPossibleValue(x, j, val))
-                    ++constraints;
-            }
-            for (int j=minY+3; j<9; ++j) {
-                if (board.isEmpty(x, j) && board.isPossibleValue(x, j, val))
-                    ++constraints;
-            }
-
-            constraintPairs.push_back(array<int, 2>{val, constraints});
-        } // End for each possible value of cell (x, y)
-
-        // Order the possible values from least constraining to most constraining
-        sort(constraintPairs.begin(), constraintPairs.end(),
-             [](const auto& a, const auto& b) { return a[1] < b[1]; });
-        transform(constraintPairs.begin(), constraintPairs.end(), values.begin(),
-                  [](auto& p) { return move(p[0]); });
-
-        return values;
-    }
-    // Else, not using heuristic. Return the possible values unaltered.
-    else {
-        return board.getValues(x, y);
-    }
-}
-
-bool SudokuBacktrack::forwardCheck(Sudoku& board, int x, int y
-                      , vector<array<int, 2>> &removedVars) const {
-
-    if (heuristic == 2 || heuristic == 3) {
-        removedVars.clear();
-        int value = board.getCell(x, y);
-
-        int minX = x/3*3;
-        int minY = y/3*3;
-
-        // For each cell in the same 3x3 subgrid
-        for (int i = minX; i < minX + 3; ++i) {
-            for (int j = minY; j < minY + 3; ++j) {
-                if (i == x && j == y) continue;
-
-                // Remove value
-                if (board.removeValue(i, j, value)) {
-                    removedVars.push_back(array<int, 2>{i, j});
-                }
-                // // If empty cells have no more possible values, then failure
-                if (board.isEmpty(i, j) && board.getValues(i, j).size() == 0) {
-                    return false;
-                }
-            }
-        }
-
-        // Check cells along same row, excluding the already checked
-        // 3x3 subgrid
-        for (int i=0; i<minX; ++i) {
-            if (board.removeValue(i, y, value)) {
-                removedVars.push_back(array<int, 2>{i, y});
-            }
-            if (board.isEmpty(i, y) && board.getValues(i, y).size() == 0) {
-                return false;
-            }
-        }
-        for (int i=minX+3; i<9; ++i) {
-            if (board.removeValue(i, y, value)) {
-                removedVars.push_back(array<int, 2>{i, y});
-            }
-            if (board.isEmpty(i, y) && board.getValues(i, y).size() == 0) {
-                return false;
-            }
-        }
-
-        // Check cells in same column
-        for (int j=0; j<minY; ++j) {
-            if (board.removeValue(x, j, value)) {
-                removedVars.push_back(array<int, 2>{x, j});
-            }
-            if (board.isEmpty(x, j) && board.getValues(x, j).size() == 0) {
-                return false;
-            }
-        }
-        for (int j=minY+3; j<9; ++j) {
-            if (board.removeValue(x, j, value)) {
-                removedVars.push_back(array<int, 2>{x, j});
-            }
-            if (board.isEmpty(x, j) && board.getValues(x, j).size() == 0) {
-                return false;
-            }
-        }
-    }
-    return true;
-}
-
-void SudokuBacktrack::revertInferences(Sudoku& board, int value
-                      , vector<array<int, 2>> &removedVars) const {
-
-    for (auto it = removedVars.begin(); it != removedVars.end(); ++it) {
-        bool success = board.addValue((*it)[0], (*it)[1], value);
-        assert(success);
-    }
-    removedVars.clear();
-}
-
-bool SudokuBacktrack::solve(Sudoku& board) const {
-    // Check if board is solved
-    if (board.isSolved()) return true;
-    if (board.getNumEmptyCells() == 0) return false;
-
-    // Get the next variable and its possible values
-    array<int, 2> loc = getNextVar(board);
-    int x = loc[0];
-    int y = loc[1];
-    list<int> values = getValues(board, x, y);
-
-    // For each possible value of cell (x, y)
-    for (int value : values) { // (auto it = values.begin(); it != values.end(); ++it) {
-
-        vector<array<int, 2>> removedVars;
-        int oldValue = board.getCell(x, y);
-        // int value = *it;
-
-        // If value is consistent
-        if (board.isConsistent(x, y, value)) {
-            // Set cell to it
-            board.setCell(x, y, value);
-
-            // If forward check is consistent
-            if (forwardCheck(board, x, y, removedVars)) {
-                // Solve for current board state
-                if (solve(board)) return true;
-            }
-        }
-
-        board.setCell(x, y, oldValue);
-        revertInferences(board, value, removedVars);
-    }
-
-    return false;
-}
+#include "sudoku_backtrack.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+using namespace std;
+
+template <int N>
+struct BasicSudokuBacktrack<N>::ParallelSearch {
+    ThreadPool &pool;
+
+    // Set once a solution is found, to stop the other workers.
+    atomic<bool> found{false};
+
+    // Guards numTasks and solution. Signalled when numTasks reaches 0.
+    std::mutex mutex;
+    condition_variable finished;
+
+    // Number of subtrees queued or running.
+    int numTasks = 0;
+
+    Board solution;
+
+    // Sum of the stats of every subtree. Guarded by mutex.
+    SearchStats stats;
+
+    // Conflicts of every worker, conflicts[i] for worker i, or null
+    // without backjumping.
+    const unique_ptr<Conflicts> *conflicts = nullptr;
+
+    explicit ParallelSearch(ThreadPool &pool) : pool(pool) {}
+};
+
+template <int N>
+struct BasicSudokuBacktrack<N>::Conflicts {
+    static constexpr int TRAIL_SIZE = NUM_CELLS + NUM_CELLS*SIZE;
+
+    // Index of a change that keeps a value out of a cell after it, if
+    // there's none, see blocker.
+    static const int NOT_BLOCKED = -2;
+
+    // Set of frames of the search, with bit k set for frames[k].
+    struct FrameSet {
+        array<uint32_t, (NUM_CELLS + 31) / 32> words{};
+
+        inline void add(int k) {
+            words[k / 32] |= 1u << (k % 32);
+        }
+
+        inline void remove(int k) {
+            words[k / 32] &= ~(1u << (k % 32));
+        }
+
+        // Adds frames 0 to k.
+        void addUpTo(int k) {
+            for (int i=0; i<k/32; ++i) words[i] = ~0u;
+            words[k / 32] |= ~0u >> (31 - k % 32);
+        }
+
+        FrameSet& operator|=(const FrameSet &other) {
+            for (size_t i=0; i<words.size(); ++i) words[i] |= other.words[i];
+            return *this;
+        }
+
+        int size() const {
+            int count = 0;
+            for (uint32_t word : words) count += countValues(word);
+            return count;
+        }
+
+        // Returns the most recent frame of the set, or -1 if it's empty.
+        int last() const {
+            for (int i=static_cast<int>(words.size())-1; i>=0; --i) {
+                if (words[i] == 0) continue;
+
+                int bit = 0;
+                for (uint32_t word = words[i] >> 1; word != 0; word >>= 1) ++bit;
+                return i * 32 + bit;
+            }
+            return -1;
+        }
+    };
+
+    // A value assigned to a cell, in a nogood.
+    struct Literal {
+        CellIndex cell;
+        uint8_t value;
+    };
+
+    struct Nogood {
+        array<Literal, MAX_NOGOOD_SIZE> literals;
+        int size = 0;
+    };
+
+    // Index on the trail of the changes made by the search, see
+    // Trail::positions, or -1 for the changes made before it, which follow
+    // from the puzzle.
+    array<int, NUM_CELLS*(SIZE+1)> positions;
+    array<int, TRAIL_SIZE> causes;
+
+    // sets[k] holds the earlier frames whose assignments caused the values
+    // of frames[k] tried so far to fail.
+    array<FrameSet, NUM_CELLS> sets;
+
+    // Changes whose causes are still to be found. seen[i] is the number of
+    // the last search for causes that queued change i, so every change is
+    // looked at once per search.
+    array<int, TRAIL_SIZE> pending;
+    int numPending = 0;
+    array<int, TRAIL_SIZE> seen{};
+    int numSearches = 0;
+
+    // Nogoods learned, in a ring, and for every value of every cell, the
+    // nogoods that assign it, one bit per nogood.
+    bool learning = false;
+    array<Nogood, MAX_NOGOODS> nogoods;
+    int numLearned = 0;
+    array<uint32_t, NUM_CELLS*SIZE> watches{};
+
+    // Forgets the changes and nogoods of the last search, and starts one
+    // that learns nogoods if learn.
+    void reset(bool learn) {
+        learning = learn;
+        positions.fill(-1);
+        seen.fill(0);
+        numSearches = 0;
+        if (numLearned > 0) watches.fill(0);
+        numLearned = 0;
+    }
+
+    // Returns the index of the assignment of cell if value is 0, or of the
+    // removal of value from the possible values of cell.
+    inline int position(int cell, int value) const {
+        return positions[cell*(SIZE+1) + value];
+    }
+
+    // Starts a search for the causes of a failure.
+    inline void begin() {
+        ++numSearches;
+        numPending = 0;
+    }
+
+    // Queues change index, if the search made it.
+    inline void add(int index) {
+        if (index < 0 || seen[index] == numSearches) return;
+        seen[index] = numSearches;
+        pending[numPending++] = index;
+    }
+
+    // Returns the frame that made change index, or -1 if it was made before
+    // the first frame.
+    static int frameOf(int index, const Frame *frames, int numFrames) {
+        int low = 0;
+        int high = numFrames;
+        while (low < high) {
+            int mid = (low + high) / 2;
+            if (frames[mid].mark <= index) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low - 1;
+    }
+
+    // Returns the index of the change before change index that keeps value
+    // out of cell, its assignment or the removal of value, -1 if the puzzle
+    // does, or NOT_BLOCKED if value could still go in cell.
+    int blocker(const Board& board, int cell, int value, int index) const {
+        if (!board.isEmpty(cell) && position(cell, 0) < index) return position(cell, 0);
+        if (!board.isPossibleValue(cell, value) && position(cell, value) < index) {
+            return position(cell, value);
+        }
+        return NOT_BLOCKED;
+    }
+
+    // Queues the changes before change index that left value as the only
+    // possible value of cell (naked single), or cell as the only place for
+    // value in one of its units (hidden single). Returns false if there are
+    // neither.
+    bool addSingleCauses(const Board& board, int cell, int value, int index) {
+        bool naked = true;
+        for (int v=1; v<=SIZE && naked; ++v) {
+            naked = v == value || blocker(board, cell, v, index) != NOT_BLOCKED;
+        }
+        if (naked) {
+            for (int v=1; v<=SIZE; ++v) {
+                if (v != value) add(position(cell, v));
+            }
+            return true;
+        }
+
+        for (int unit : Tables::CELL_UNITS[cell]) {
+            bool hidden = true;
+            for (CellIndex other : Tables::UNITS[unit]) {
+                if (other != cell && blocker(board, other, value, index) == NOT_BLOCKED) {
+                    hidden = false;
+                    break;
+                }
+            }
+            if (!hidden) continue;
+
+            for (CellIndex other : Tables::UNITS[unit]) {
+                if (other != cell) add(blocker(board, other, value, index));
+            }
+            return true;
+        }
+        return false;
+    }
+
+    // Queues the changes that left an empty cell of board without possible
+    // values, or a value without a place in a unit. Returns false if board
+    // has neither.
+    bool addContradiction(const Board& board, int index) {
+        int cell = board.findWipedOutCell();
+        if (cell >= 0) {
+            for (int v=1; v<=SIZE; ++v) add(position(cell, v));
+            return true;
+        }
+
+        for (const auto &unit : Tables::UNITS) {
+            Mask missing = Board::ALL_VALUES;
+            for (CellIndex other : unit) {
+                missing &= board.isEmpty(other) ? ~board.getValues(other)
+                                                : ~valueBit<Mask>(board.getCell(other));
+            }
+            if (missing == 0) continue;
+
+            int value = lowestValue(missing);
+            for (CellIndex other : unit) add(blocker(board, other, value, index));
+            return true;
+        }
+        return false;
+    }
+
+    // Adds to found the frames whose assignments the queued changes follow
+    // from, and empties the queue.
+    void explain(const Board& board, const Trail &trail, const Frame *frames
+                 , int numFrames, FrameSet &found) {
+        while (numPending > 0) {
+            int index = pending[--numPending];
+            int frame = frameOf(index, frames, numFrames);
+            if (frame < 0) continue;
+
+            // The value the frame tried
+            if (index == frames[frame].mark) {
+                found.add(frame);
+                continue;
+            }
+
+            const Change &change = trail.changes[index];
+            bool explained = true;
+            if (change.assigned) {
+                explained = addSingleCauses(board, change.cell, change.value, index);
+            } else if (causes[index] >= 0) {
+                add(causes[index]);
+            } else {
+                explained = false;
+            }
+
+            // Pairs and intersections follow from too many changes to track,
+            // so every frame up to the one that made the change is blamed
+            if (!explained) found.addUpTo(frame);
+        }
+    }
+
+    // Adds the frames that caused value to fail for the last frame to its
+    // conflict set.
+    void fail(const Board& board, const Trail &trail, const Frame *frames
+              , int numFrames, int value) {
+        const int k = numFrames - 1;
+        begin();
+
+        FrameSet found;
+        bool explained = false;
+        if (trail.size == frames[k].mark) {
+            // Without forward checking, value is already in a peer
+            for (CellIndex peer : Tables::PEERS[frames[k].cell]) {
+                if (board.getCell(peer) == value) {
+                    add(position(peer, 0));
+                    explained = true;
+                    break;
+                }
+            }
+        } else {
+            explained = addContradiction(board, trail.size);
+        }
+        if (!explained) found.addUpTo(k);
+
+        explain(board, trail, frames, numFrames, found);
+        found.remove(k);
+        sets[k] |= found;
+    }
+
+    // Blames every earlier frame for the last frame, ex. once a solution is
+    // found below it, since backjumping would skip the other solutions.
+    inline void blameAll(int numFrames) {
+        if (numFrames > 1) sets[numFrames-1].addUpTo(numFrames - 2);
+    }
+
+    // Returns true if assigning value to the cell of the last frame
+    // completes a nogood, and adds the frames that assigned the rest of the
+    // nogood to its conflict set.
+    bool refuses(const Board& board, const Trail &trail, const Frame *frames
+                 , int numFrames, int value) {
+        const int k = numFrames - 1;
+        const int cell = frames[k].cell;
+
+        for (uint32_t bits = watches[cell*SIZE + value-1]; bits != 0; bits &= bits - 1) {
+            const Nogood &nogood = nogoods[lowestValue(bits) - 1];
+
+            bool complete = true;
+            for (int i=0; i<nogood.size && complete; ++i) {
+                const Literal &literal = nogood.literals[i];
+                complete = literal.cell == cell || board.getCell(literal.cell) == literal.value;
+            }
+            if (!complete) continue;
+
+            begin();
+            for (int i=0; i<nogood.size; ++i) {
+                if (nogood.literals[i].cell != cell) add(position(nogood.literals[i].cell, 0));
+            }
+            FrameSet found;
+            explain(board, trail, frames, numFrames, found);
+            found.remove(k);
+            sets[k] |= found;
+            return true;
+        }
+        return false;
+    }
+
+    // Learns the assignments of the frames of found as a nogood, unless
+    // there are too many.
+    void learn(const Board& board, const Frame *frames, const FrameSet &found) {
+        int size = found.size();
+        if (size == 0 || size > MAX_NOGOOD_SIZE) return;
+
+        const int slot = numLearned++ % MAX_NOGOODS;
+        Nogood &nogood = nogoods[slot];
+        for (int i=0; i<nogood.size; ++i) {
+            const Literal &literal = nogood.literals[i];
+            watches[literal.cell*SIZE + literal.value-1] &= ~(1u << slot);
+        }
+
+        nogood.size = 0;
+        for (size_t i=0; i<found.words.size(); ++i) {
+            for (uint32_t bits = found.words[i]; bits != 0; bits &= bits - 1) {
+                int cell = frames[i*32 + lowestValue(bits) - 1].cell;
+                int value = board.getCell(cell);
+                nogood.literals[nogood.size++] = Literal{static_cast<CellIndex>(cell)
+                                                         , static_cast<uint8_t>(value)};
+                watches[cell*SIZE + value-1] |= 1u << slot;
+            }
+        }
+    }
+
+    // Returns the frame to go back to once every value of the last frame
+    // failed, the most recent frame that caused one of the failures or
+    // removed one of the other values of its cell, or -1 if there's none,
+    // so the puzzle has no more solutions. Merges the conflict set of the
+    // last frame into the one of that frame, and learns it as a nogood if
+    // learning.
+    // requires: the changes of the last frame are undone
+    int backjump(const Board& board, const Trail &trail, const Frame *frames
+                 , int numFrames) {
+        const int k = numFrames - 1;
+        const int cell = frames[k].cell;
+        begin();
+        for (int v=1; v<=SIZE; ++v) {
+            if (!board.isPossibleValue(cell, v)) add(position(cell, v));
+        }
+
+        FrameSet &found = sets[k];
+        explain(board, trail, frames, numFrames, found);
+        found.remove(k);
+
+        int target = found.last();
+        if (target < 0) return -1;
+
+        if (learning) learn(board, frames, found);
+        sets[target] |= found;
+        sets[target].remove(target);
+        return target;
+    }
+};
+
+template <int N>
+int BasicSudokuBacktrack<N>::getNextVar(const Board& board) const {
+    assert(board.getNumEmptyCells() > 0);
+
+    // If using minimum remaining values heuristic
+    if (heuristic == 3) {
+        // Find empty cells with least remaining possible values
+        array<int, NUM_CELLS> leastVars;
+        int numLeastVars = board.getFewestValuesCells(leastVars);
+        if (numLeastVars == 1) return leastVars[0];
+
+        int maxConstraints = -1;
+        int bestVar = -1;
+
+        // If multiple cells, use most constraining variable as tiebreaker.
+        // For each cell in leastVars
+        for (int k=0; k<numLeastVars; ++k) {
+            int var = leastVars[k];
+
+            // Count number of empty cells in the same row, column, and NxN
+            // subgrid
+            int constraints = 0;
+            for (CellIndex peer : Tables::PEERS[var]) {
+                if (board.isEmpty(peer)) ++constraints;
+            }
+
+            // Set bestVar to cell with most number of constraints
+            if (constraints > maxConstraints) {
+                maxConstraints = constraints;
+                bestVar = var;
+            }
+        } // End for each cell in leastVars
+
+        assert(bestVar != -1);
+        return bestVar;
+    }
+    // Else, not using heuristic for getting next variable
+    else {
+        // Return any empty cell
+        for (int cell=0; cell<NUM_CELLS; ++cell) {
+            if (board.isEmpty(cell)) return cell;
+        }
+    }
+
+    // No empty cell found. Should never reach this point.
+    assert(false);
+    return 0;
+}
+
+template <int N>
+int BasicSudokuBacktrack<N>::getValues(const Board& board, int cell
+                                      , array<int, SIZE> &values) const {
+
+    // Unpack the possible values of cell in increasing order
+    int size = 0;
+    for (Mask mask = board.getValues(cell); mask != 0; mask &= mask - 1) {
+        values[size++] = lowestValue(mask);
+    }
+
+    // If using least constraining value heuristic
+    if (heuristic == 3) {
+
+        // constraints[i] is the number of constraints for values[i].
+        // ex. If the board is full, then constraints[i] = 0 for all i.
+        //     If cell only has a possible value of 9, then values[0] = 9.
+        //     In addition, if all other cells in the same row, column, and NxN subgrid are
+        //     filled except for one cell that also has a possible value of 9, then
+        //     constraints[0] = 1.
+        array<int, SIZE> constraints;
+
+        // For each possible value of cell
+        for (int v=0; v<size; ++v) {
+
+            // Count number of empty cells in the same row, column, and NxN
+            // subgrid that have the same possible value.
+            int count = 0;
+            for (CellIndex peer : Tables::PEERS[cell]) {
+                if (board.isEmpty(peer) && board.isPossibleValue(peer, values[v])) {
+                    ++count;
+                }
+            }
+
+            constraints[v] = count;
+        } // End for each possible value of cell
+
+        // Order the possible values from least constraining to most
+        // constraining. Insertion sort, since there are at most 9 values.
+        for (int i=1; i<size; ++i) {
+            int val = values[i];
+            int count = constraints[i];
+            int j = i;
+            for (; j > 0 && constraints[j-1] > count; --j) {
+                values[j] = values[j-1];
+                constraints[j] = constraints[j-1];
+            }
+            values[j] = val;
+            constraints[j] = count;
+        }
+    }
+
+    return size;
+}
+
+template <int N>
+bool BasicSudokuBacktrack<N>::forwardCheck(Board& board, int cell
+                                          , Trail &trail) const {
+
+    if (heuristic == 2 || heuristic == 3) {
+        int value = board.getCell(cell);
+
+        // Remove value from each cell in the same row, column, and NxN
+        // subgrid. If empty cells have no more possible values, then failure
+        const int cause = trail.size - 1;
+        return board.removeFromPeers(cell, value, [&](int peer) {
+            trail.push(peer, value, false);
+            if (trail.causes) trail.causes[trail.size - 1] = cause;
+        });
+    }
+    return true;
+}
+
+template <int N>
+bool BasicSudokuBacktrack<N>::assign(Board& board, int cell, int value
+                                    , Trail &trail) const {
+    if (!board.isConsistent(cell, value)) return false;
+
+    board.setCell(cell, value);
+    trail.push(cell, value, true);
+    return forwardCheck(board, cell, trail);
+}
+
+template <int N>
+bool BasicSudokuBacktrack<N>::eliminate(Board& board, int cell, Mask mask
+                                       , Trail &trail, bool &changed) const {
+    for (mask &= board.getValues(cell); mask != 0; mask &= mask - 1) {
+        int value = lowestValue(mask);
+        board.removeValue(cell, value);
+        trail.push(cell, value, false);
+        changed = true;
+    }
+    return board.getValues(cell) != 0;
+}
+
+template <int N>
+bool BasicSudokuBacktrack<N>::propagate(Board& board, Trail &trail) const {
+    if (inference <= 0 || (heuristic != 2 && heuristic != 3)) return true;
+
+    // Repeat until no more inferences can be made, trying the cheaper
+    // inferences first.
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        if (!propagateSingles(board, trail, changed)) return false;
+        if (changed || inference < 2) continue;
+
+        if (!propagatePairs(board, trail, changed)) return false;
+        if (changed) continue;
+
+        if (!propagateIntersections(board, trail, changed)) return false;
+    }
+    return true;
+}
+
+template <int N>
+bool BasicSudokuBacktrack<N>::propagateSingles(Board& board, Trail &trail
+                                              , bool &changed) const {
+    // Naked singles
+    for (int cell=0; cell<NUM_CELLS; ++cell) {
+        if (!board.isEmpty(cell)) continue;
+
+        Mask values = board.getValues(cell);
+        if (values == 0) return false;
+
+        if (countValues(values) == 1) {
+            if (!assign(board, cell, lowestValue(values), trail)) return false;
+            changed = true;
+        }
+    }
+
+    // Hidden singles
+    for (const auto &unit : Tables::UNITS) {
+        // Values that fit in at least one and in more than one empty cell,
+        // and values already placed in the unit
+        Mask once = 0;
+        Mask twice = 0;
+        Mask placed = 0;
+
+        for (CellIndex cell : unit) {
+            if (board.isEmpty(cell)) {
+                Mask values = board.getValues(cell);
+                twice |= once & values;
+                once |= values;
+            } else {
+                placed |= valueBit<Mask>(board.getCell(cell));
+            }
+        }
+
+        // A value that fits nowhere in the unit can't be placed
+        if ((once | placed) != Board::ALL_VALUES) return false;
+
+        // Assign every value that fits in exactly one cell. Each assignment
+        // may remove values from other cells of the unit, so the cell is
+        // looked up again.
+        for (Mask hidden = once & ~twice & ~placed; hidden != 0
+             ; hidden &= hidden - 1) {
+            int value = lowestValue(hidden);
+
+            int i = 0;
+            for (; i<SIZE; ++i) {
+                if (board.isEmpty(unit[i]) && board.isPossibleValue(unit[i], value)) break;
+            }
+            if (i == SIZE) return false;
+
+            if (!assign(board, unit[i], value, trail)) return false;
+            changed = true;
+        }
+    }
+
+    return true;
+}
+
+template <int N>
+bool BasicSudokuBacktrack<N>::propagatePairs(Board& board, Trail &trail
+                                            , bool &changed) const {
+    for (const auto &unit : Tables::UNITS) {
+        array<Mask, SIZE> values;
+
+        // positions[v-1] is the set of empty cells of the unit where value v
+        // fits, with bit i set for cell i.
+        array<Mask, SIZE> positions{};
+
+        for (int i=0; i<SIZE; ++i) {
+            values[i] = board.isEmpty(unit[i]) ? board.getValues(unit[i]) : 0;
+
+            for (Mask m = values[i]; m != 0; m &= m - 1) {
+                positions[lowestValue(m) - 1] |= 1 << i;
+            }
+        }
+
+        // Naked pairs. The pair's values are removed from every other cell.
+        for (int i=0; i<SIZE; ++i) {
+            if (countValues(values[i]) != 2) continue;
+
+            for (int j=i+1; j<SIZE; ++j) {
+                if (values[j] != values[i]) continue;
+
+                for (int k=0; k<SIZE; ++k) {
+                    if (k == i || k == j || values[k] == 0) continue;
+                    if (!eliminate(board, unit[k], values[i], trail, changed)) {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        // Hidden pairs. Every other value is removed from the pair's cells.
+        for (int a=0; a<SIZE; ++a) {
+            if (countValues(positions[a]) != 2) continue;
+
+            for (int b=a+1; b<SIZE; ++b) {
+                if (positions[b] != positions[a]) continue;
+
+                Mask pair = valueBit<Mask>(a+1) | valueBit<Mask>(b+1);
+                for (Mask m = positions[a]; m != 0; m &= m - 1) {
+                    int i = lowestValue(m) - 1;
+                    if (!eliminate(board, unit[i], Board::ALL_VALUES & ~pair
+                                   , trail, changed)) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+template <int N>
+bool BasicSudokuBacktrack<N>::propagateIntersections(Board& board, Trail &trail
+                                                    , bool &changed) const {
+    // For each NxN subgrid, and each row and column crossing it
+    for (int box=0; box<SIZE; ++box) {
+        int minX = box % N * N;
+        int minY = box / N * N;
+
+        // rowValues[k] holds the possible values of the empty cells in row
+        // minY + k of the subgrid, colValues[k] in column minX + k.
+        array<Mask, N> rowValues{};
+        array<Mask, N> colValues{};
+        for (int i=0; i<N; ++i) {
+            for (int j=0; j<N; ++j) {
+                if (board.isEmpty(minX + i, minY + j)) {
+                    Mask values = board.getValues(minX + i, minY + j);
+                    colValues[i] |= values;
+                    rowValues[j] |= values;
+                }
+            }
+        }
+
+        for (int k=0; k<N; ++k) {
+            int y = minY + k;
+            int x = minX + k;
+
+            // Pointing: values of the subgrid that only fit in this row or
+            // column are removed from the rest of the row or column.
+            Mask rowOthers = 0;
+            Mask colOthers = 0;
+            for (int j=0; j<N; ++j) {
+                if (j == k) continue;
+                rowOthers |= rowValues[j];
+                colOthers |= colValues[j];
+            }
+            Mask rowOnly = rowValues[k] & ~rowOthers;
+            Mask colOnly = colValues[k] & ~colOthers;
+
+            // Box line reduction: values of the row or column that only fit
+            // in this subgrid are removed from the rest of the subgrid.
+            Mask rowOutside = 0;
+            Mask colOutside = 0;
+            for (int i=0; i<SIZE; ++i) {
+                if (i / N * N != minX && board.isEmpty(i, y)) {
+                    rowOutside |= board.getValues(i, y);
+                }
+                if (i / N * N != minY && board.isEmpty(x, i)) {
+                    colOutside |= board.getValues(x, i);
+                }
+            }
+            Mask rowClaimed = rowValues[k] & ~rowOutside;
+            Mask colClaimed = colValues[k] & ~colOutside;
+
+            for (int i=0; i<SIZE; ++i) {
+                // Rest of the row and column
+                if (i / N * N != minX && board.isEmpty(i, y)
+                    && !eliminate(board, Board::cellIndex(i, y), rowOnly, trail, changed)) {
+                    return false;
+                }
+                if (i / N * N != minY && board.isEmpty(x, i)
+                    && !eliminate(board, Board::cellIndex(x, i), colOnly, trail, changed)) {
+                    return false;
+                }
+
+                // Rest of the subgrid
+                int bx = minX + i % N;
+                int by = minY + i / N;
+                if (by != y && board.isEmpty(bx, by)
+                    && !eliminate(board, Board::cellIndex(bx, by), rowClaimed, trail, changed)) {
+                    return false;
+                }
+                if (bx != x && board.isEmpty(bx, by)
+                    && !eliminate(board, Board::cellIndex(bx, by), colClaimed, trail, changed)) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+template <int N>
+void BasicSudokuBacktrack<N>::undo(Board& board, Trail &trail, int mark) const {
+    while (trail.size > mark) {
+        const Change &change = trail.changes[--trail.size];
+
+        if (change.assigned) {
+            board.setCell(change.cell, 0);
+        } else {
+            bool success = board.addValue(change.cell, change.value);
+            assert(success);
+            (void)success;
+        }
+    }
+}
+
+template <int N>
+BasicSudokuBacktrack<N>::BasicSudokuBacktrack() = default;
+
+template <int N>
+BasicSudokuBacktrack<N>::BasicSudokuBacktrack(const BasicSudokuBacktrack &other)
+    : heuristic(other.heuristic), inference(other.inference)
+    , backjumping(other.backjumping), stats(other.stats) {}
+
+template <int N>
+BasicSudokuBacktrack<N>& BasicSudokuBacktrack<N>::operator=(const BasicSudokuBacktrack &other) {
+    heuristic = other.heuristic;
+    inference = other.inference;
+    backjumping = other.backjumping;
+    stats = other.stats;
+    return *this;
+}
+
+template <int N>
+BasicSudokuBacktrack<N>::~BasicSudokuBacktrack() = default;
+
+template <int N>
+void BasicSudokuBacktrack<N>::reserveConflicts(int count) {
+    if (backjumping <= 0) return;
+    while (static_cast<int>(searchConflicts.size()) < count) {
+        searchConflicts.push_back(make_unique<Conflicts>());
+    }
+}
+
+template <int N>
+bool BasicSudokuBacktrack<N>::solve(Board& board) {
+    stats = SearchStats();
+    SearchBudget budget;
+    reserveConflicts(1);
+    Conflicts *conflicts = backjumping > 0 ? searchConflicts[0].get() : nullptr;
+    return search(board, nullptr, conflicts, 0, 1, stats, budget) == 1;
+}
+
+template <int N>
+SolveResult BasicSudokuBacktrack<N>::solveWithin(Board& board
+                                                , const SearchLimits &limits) {
+    stats = SearchStats();
+    SearchBudget budget(&limits);
+    reserveConflicts(1);
+    Conflicts *conflicts = backjumping > 0 ? searchConflicts[0].get() : nullptr;
+    if (search(board, nullptr, conflicts, 0, 1, stats, budget) == 1) return SolveResult::Solved;
+    return budget.isStopped() ? budget.getReason() : SolveResult::Unsolvable;
+}
+
+template <int N>
+int BasicSudokuBacktrack<N>::countSolutions(Board& board, int limit) {
+    stats = SearchStats();
+    if (limit <= 0) return 0;
+    SearchBudget budget;
+    reserveConflicts(1);
+    Conflicts *conflicts = backjumping > 0 ? searchConflicts[0].get() : nullptr;
+    return search(board, nullptr, conflicts, 0, limit, stats, budget);
+}
+
+template <int N>
+CountResult BasicSudokuBacktrack<N>::countWithin(Board& board, int limit
+                                                 , const SearchLimits &limits) {
+    stats = SearchStats();
+    if (limit <= 0) return CountResult();
+    SearchBudget budget(&limits);
+    reserveConflicts(1);
+    Conflicts *conflicts = backjumping > 0 ? searchConflicts[0].get() : nullptr;
+    int count = search(board, nullptr, conflicts, 0, limit, stats, budget);
+    return makeCountResult(count, limit, budget);
+}
+
+template <int N>
+unique_ptr<BasicSudokuSolver<N>> BasicSudokuBacktrack<N>::clone() const {
+    return make_unique<BasicSudokuBacktrack>(*this);
+}
+
+template <int N>
+bool BasicSudokuBacktrack<N>::deduce(Board& board) const {
+    Trail trail;
+    return propagate(board, trail);
+}
+
+template <int N>
+bool BasicSudokuBacktrack<N>::solveParallel(Board& board, ThreadPool& pool) {
+    assert(pool.getWorkerIndex() == -1);
+
+    ParallelSearch parallel(pool);
+    parallel.numTasks = 1;
+    reserveConflicts(1 + pool.getNumThreads());
+    if (backjumping > 0) parallel.conflicts = searchConflicts.data() + 1;
+
+    pool.submit([this, &board, &parallel] {
+        runSubtree(board, parallel, 0);
+    });
+
+    // Wait for every subtree, including ones that gave up early, since they
+    // reference parallel.
+    unique_lock<std::mutex> lock(parallel.mutex);
+    parallel.finished.wait(lock, [&parallel] { return parallel.numTasks == 0; });
+
+    stats = parallel.stats;
+    if (parallel.found) board = parallel.solution;
+    return parallel.found;
+}
+
+template <int N>
+void BasicSudokuBacktrack<N>::runSubtree(Board& board, ParallelSearch &parallel
+                                        , int depth) const {
+
+    // A worker runs one subtree at a time, so it can reuse its conflicts
+    Conflicts *conflicts = nullptr;
+    if (parallel.conflicts) conflicts = parallel.conflicts[parallel.pool.getWorkerIndex()].get();
+
+    SearchStats subtreeStats;
+    SearchBudget budget;
+    bool solved = !parallel.found.load(memory_order_relaxed)
+                  && search(board, &parallel, conflicts, depth, 1, subtreeStats, budget) == 1;
+
+    lock_guard<std::mutex> lock(parallel.mutex);
+    parallel.stats += subtreeStats;
+    if (solved && !parallel.found) {
+        parallel.solution = board;
+        parallel.found = true;
+    }
+    if (--parallel.numTasks == 0) parallel.finished.notify_all();
+}
+
+template <int N>
+int BasicSudokuBacktrack<N>::search(Board& board, ParallelSearch *parallel
+                                   , Conflicts *conflicts, int depth, int limit
+                                   , SearchStats &stats, SearchBudget &budget) const {
+    // Check if board is solved
+    if (board.isSolved()) return 1;
+    if (board.getNumEmptyCells() == 0) return 0;
+
+    Trail trail;
+    array<Frame, NUM_CELLS> frames;
+    int numFrames = 0;
+
+    // Nogoods only hold for searches that stop at the first solution and
+    // see every subtree
+    if (backjumping > 0) {
+        assert(conflicts);
+        conflicts->reset(backjumping >= 2 && limit == 1 && !parallel);
+        trail.positions = conflicts->positions.data();
+        trail.causes = conflicts->causes.data();
+    } else {
+        conflicts = nullptr;
+    }
+
+    // Make inferences from the initial board
+    bool consistent = propagate(board, trail);
+    if constexpr (STATS_ENABLED) stats.valuesPropagated += trail.size;
+    if (!consistent) return 0;
+    if (board.isSolved()) return 1;
+    if (board.getNumEmptyCells() == 0) return 0;
+
+    int count = 0;
+
+    // Starts a frame for the next variable and its possible values
+    auto pushFrame = [&]() {
+        Frame &frame = frames[numFrames++];
+        {
+            StatsTimer timer(stats.varOrderingTime);
+            frame.cell = getNextVar(board);
+        }
+        {
+            StatsTimer timer(stats.valueOrderingTime);
+            frame.numValues = getValues(board, frame.cell, frame.values);
+        }
+        frame.next = 0;
+        frame.mark = trail.size;
+        if (conflicts) conflicts->sets[numFrames-1] = typename Conflicts::FrameSet();
+
+        if constexpr (STATS_ENABLED) {
+            stats.maxDepth = max(stats.maxDepth, depth + numFrames);
+        }
+    };
+    pushFrame();
+
+    while (numFrames > 0) {
+        Frame &frame = frames[numFrames-1];
+
+        // Undo the previous value tried for the cell, if any
+        undo(board, trail, frame.mark);
+
+        // All possible values of the cell failed, so backtrack, or jump back
+        // to the last cell that caused a failure
+        if (frame.next == frame.numValues) {
+            if constexpr (STATS_ENABLED) ++stats.backtracks;
+            if (conflicts) {
+                int target = conflicts->backjump(board, trail, frames.data(), numFrames);
+                if constexpr (STATS_ENABLED) {
+                    if (target < numFrames - 2) ++stats.backjumps;
+                }
+                numFrames = target + 1;
+            } else {
+                --numFrames;
+            }
+            continue;
+        }
+        int v = frame.next++;
+        int value = frame.values[v];
+
+        // Stop if another worker found a solution
+        if (parallel && parallel->found.load(memory_order_relaxed)) {
+            return 0;
+        }
+
+        // Stop if the search ran out of time or nodes, or was cancelled
+        if (budget.spend()) return count;
+
+        // Set cell to value. If value, forward checking, or the
+        // inferences are inconsistent, try the next value.
+        if constexpr (STATS_ENABLED) ++stats.nodes;
+
+        if (conflicts && conflicts->numLearned > 0
+            && conflicts->refuses(board, trail, frames.data(), numFrames, value)) {
+            continue;
+        }
+
+        consistent = assign(board, frame.cell, value, trail);
+        int assigned = trail.size;
+        if constexpr (STATS_ENABLED) {
+            // The first change is the assignment itself
+            if (assigned > frame.mark) stats.valuesPruned += assigned - frame.mark - 1;
+        }
+        if (!consistent) {
+            if (conflicts) conflicts->fail(board, trail, frames.data(), numFrames, value);
+            continue;
+        }
+
+        consistent = propagate(board, trail);
+        if constexpr (STATS_ENABLED) stats.valuesPropagated += trail.size - assigned;
+        if (!consistent) {
+            if (conflicts) conflicts->fail(board, trail, frames.data(), numFrames, value);
+            continue;
+        }
+
+        // Hand off the subtree of this value if workers are idle, except
+        // for the last value, which this worker searches itself.
+        int frameDepth = depth + numFrames - 1;
+        if (parallel && frameDepth < MAX_SPLIT_DEPTH && v+1 < frame.numValues
+            && parallel->pool.getNumQueued() < parallel->pool.getNumThreads()) {
+            {
+                lock_guard<std::mutex> lock(parallel->mutex);
+                ++parallel->numTasks;
+            }
+            parallel->pool.submit([this, board, parallel, frameDepth]() mutable {
+                runSubtree(board, *parallel, frameDepth+1);
+            });
+            if (conflicts) conflicts->blameAll(numFrames);
+            continue;
+        }
+
+        // Check if board is solved, or search the current board state. Once
+        // a solution is counted, search for the next one by trying the next
+        // value.
+        if (board.isSolved()) {
+            if (++count == limit) return count;
+            if (conflicts) conflicts->blameAll(numFrames);
+            continue;
+        }
+        if (board.getNumEmptyCells() == 0) {
+            if (conflicts) conflicts->blameAll(numFrames);
+            continue;
+        }
+        pushFrame();
+    }
+
+    return count;
+}
+
+template class BasicSudokuBacktrack<3>;
+template class BasicSudokuBacktrack<4>;
+template class BasicSudokuBacktrack<5>;
@@ -1,50 +1,293 @@
-#pragma once
-
-#include <vector>
-#include "sudoku.h"
-
-// SudokuBacktrack implements the backtracking algorithm for a sudoku puzzle.
-// Optional heuristics can be set to improve the search.
-class SudokuBacktrack {
-    // Flag for which heuristic to use.
-    // 1 = no heuristic
-    // 2 = forward checking
-    // 3 = forward checking with minimum remaining values, most constraining
-    //     variable, and least constraining value
-    // All other values = no heuristic
-    int heuristic;
-
-    // Returns the location of the next empty cell of board.
-    // ex. On an empty board, getNextVar returns (0, 0).
-    // requires: board has >= 1 empty cell
-    std::array<int, 2> getNextVar(const Sudoku& board) const;
-
-    // Returns the possible values of the cell at (x, y) of board.
-    std::list<int> getValues(const Sudoku& board, int x, int y) const;
-
-    // Performs forward checking by removing the value at cell (x, y) from
-    // the possible values of cells in the same row, column, and 3x3 subgrid.
-    // Returns true if possible values are all non-empty, false otherwise.
-    // Stores the cell locations of the removed value in removedVars.
-    // effects: board may change
-    //          removedVars may change
-    bool forwardCheck(Sudoku& board, int x, int y
-                      , std::vector<std::array<int, 2>> &removedVars) const;
-
-    // Reverts the values removed by forwardCheck. Given the cell locations of
-    // the removed value, removedVars, adds the value to the possible values of
-    // those cells.
-    // effects: board may change
-    //          removedVars will be empty
-    void revertInferences(Sudoku& board, int value
-                          , std::vector<std::array<int, 2>> &removedVars) const;
-
-public:
-    inline void setHeuristic(int h) {heuristic = h;}
-
-    // Given a initial partially filled sudoku board, returns true if a
-    // solution exists, false otherwise. If a solution exists, then the board
-    // state will conatin the solution. It will contain garbage values otherwise.
-    // effects: board may change
-    bool solve(Sudoku& board) const;
-};
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "search_limits.h"
+#include "search_stats.h"
+#include "sudoku.h"
+#include "sudoku_solver.h"
+#include "thread_pool.h"
+
+// BasicSudokuBacktrack implements the backtracking algorithm for a sudoku
+// puzzle with N by N boxes. Optional heuristics can be set to improve the
+// search.
+template <int N>
+class BasicSudokuBacktrack : public BasicSudokuSolver<N> {
+    using Board = BasicSudoku<N>;
+    using Mask = typename Board::Mask;
+    using Tables = typename Board::Tables;
+    static constexpr int SIZE = Board::SIZE;
+    static constexpr int NUM_CELLS = Board::NUM_CELLS;
+
+    // Flag for which heuristic to use.
+    // 1 = no heuristic
+    // 2 = forward checking
+    // 3 = forward checking with minimum remaining values, most constraining
+    //     variable, and least constraining value
+    // All other values = no heuristic
+    int heuristic = 3;
+
+    // Flag for which inferences to make after every assignment, on top of
+    // forward checking. Inferences are repeated until no more can be made.
+    // 0 = no inferences
+    // 1 = naked singles and hidden singles
+    // 2 = level 1, naked pairs, hidden pairs, pointing, and box line
+    //     reduction
+    // Only used with forward checking, heuristic 2 or 3.
+    int inference = 0;
+
+    // Flag for where the search goes back to once every value of a cell
+    // failed.
+    // 0 = the previous cell (chronological backtracking)
+    // 1 = the most recent cell whose assignment caused one of the failures
+    //     (conflict-directed backjumping)
+    // 2 = level 1, and also learn nogoods, small sets of assignments that
+    //     can't all hold, and refuse values that complete one
+    int backjumping = 0;
+
+    // Most nogoods kept by a search, and most assignments in one. The
+    // oldest nogood is dropped to make room for a new one.
+    static const int MAX_NOGOODS = 32;
+    static const int MAX_NOGOOD_SIZE = 8;
+
+    // Stats of the last search, see getStats.
+    SearchStats stats;
+
+    // Conflict sets and nogoods of a search with backjumping.
+    struct Conflicts;
+
+    // Conflicts of the searches with backjumping, kept between searches so
+    // searching doesn't allocate memory. searchConflicts[0] is used by
+    // solve and countSolutions, and searchConflicts[1 + i] by worker i of
+    // solveParallel. Created the first time they're needed, and not copied
+    // by clone.
+    std::vector<std::unique_ptr<Conflicts>> searchConflicts;
+
+    // Creates searchConflicts up to searchConflicts[count - 1] if
+    // backjumping is on.
+    // effects: searchConflicts may change
+    void reserveConflicts(int count);
+
+    // Returns the number of the next empty cell of board, see
+    // BasicSudoku::cellIndex.
+    // ex. On an empty board, getNextVar returns 0, the cell at (0, 0).
+    // requires: board has >= 1 empty cell
+    int getNextVar(const Board& board) const;
+
+    // Stores the possible values of cell of board in values, in the order
+    // they should be tried. Returns the number of values stored.
+    // effects: values may change
+    int getValues(const Board& board, int cell
+                  , std::array<int, SIZE> &values) const;
+
+    // A change made to a board by the search. Either a value was removed
+    // from the possible values of cell, or cell was assigned value.
+    struct Change {
+        CellIndex cell;
+        std::uint8_t value;
+        bool assigned;
+    };
+
+    // Trail of the changes made to a board by the search, in order, so they
+    // can be undone when backtracking. Along one path of the search, each
+    // cell is assigned at most once and each possible value of a cell is
+    // removed at most once, which bounds the size of the trail.
+    struct Trail {
+        std::array<Change, NUM_CELLS + NUM_CELLS*SIZE> changes;
+        int size = 0;
+
+        // If not null, positions[cell*(SIZE+1)] is set to the index of the
+        // assignment of cell, and positions[cell*(SIZE+1) + value] to the
+        // index of the removal of value, as they're pushed. causes[i] is
+        // set to the index of the assignment that forward checking removed
+        // value i for, or -1 for the other changes.
+        int *positions = nullptr;
+        int *causes = nullptr;
+
+        inline void push(int cell, int value, bool assigned) {
+            assert(size < static_cast<int>(changes.size()));
+            if (positions) {
+                positions[cell*(SIZE+1) + (assigned ? 0 : value)] = size;
+                causes[size] = -1;
+            }
+            changes[size++] = Change{static_cast<CellIndex>(cell)
+                                     , static_cast<std::uint8_t>(value)
+                                     , assigned};
+        }
+    };
+
+    // A cell being assigned by the search, along with the values to try.
+    struct Frame {
+        int cell;
+        std::array<int, SIZE> values;
+        int numValues;
+
+        // Index in values of the next value to try.
+        int next;
+
+        // Size of the trail before the cell was assigned. Backtracking to
+        // this frame undoes the changes after it.
+        int mark;
+    };
+
+    // Performs forward checking by removing the value at cell from the
+    // possible values of cells in the same row, column, and 3x3 subgrid.
+    // Returns true if possible values are all non-empty, false otherwise.
+    // Records the removed values on trail.
+    // requires: the assignment of cell is the last change on trail
+    // effects: board may change
+    //          trail may change
+    bool forwardCheck(Board& board, int cell, Trail &trail) const;
+
+    // Assigns value to cell and performs forward checking. Returns
+    // true if the assignment is consistent and possible values are all
+    // non-empty, false otherwise. Records the changes on trail.
+    // effects: board may change
+    //          trail may change
+    bool assign(Board& board, int cell, int value, Trail &trail) const;
+
+    // Removes the values in mask from the possible values of empty cell.
+    // Returns true if the cell has possible values left, false
+    // otherwise. Records the removed values on trail and sets changed if a
+    // value was removed.
+    // effects: board may change
+    //          trail may change
+    //          changed may change
+    bool eliminate(Board& board, int cell, Mask mask, Trail &trail
+                   , bool &changed) const;
+
+    // Makes inferences according to the inference flag until no more can be
+    // made. Returns true if board is still consistent, false otherwise.
+    // Records the changes on trail.
+    // effects: board may change
+    //          trail may change
+    bool propagate(Board& board, Trail &trail) const;
+
+    // Assigns the empty cells with a single possible value (naked singles),
+    // and the values that only fit in one cell of a row, column, or 3x3
+    // subgrid (hidden singles). Returns false if board is inconsistent.
+    // Sets changed if anything was assigned.
+    // effects: board may change
+    //          trail may change
+    //          changed may change
+    bool propagateSingles(Board& board, Trail &trail, bool &changed) const;
+
+    // Removes possible values using naked pairs, two cells of a row, column,
+    // or 3x3 subgrid with the same two possible values, and hidden pairs,
+    // two values that only fit in the same two cells of a row, column, or
+    // 3x3 subgrid. Returns false if board is inconsistent. Sets changed if a
+    // value was removed.
+    // effects: board may change
+    //          trail may change
+    //          changed may change
+    bool propagatePairs(Board& board, Trail &trail, bool &changed) const;
+
+    // Removes possible values using the intersections of 3x3 subgrids with
+    // rows and columns. If a value only fits in one row or column of a 3x3
+    // subgrid, it is removed from the rest of the row or column (pointing).
+    // If a value only fits in one 3x3 subgrid of a row or column, it is
+    // removed from the rest of the 3x3 subgrid (box line reduction).
+    // Returns false if board is inconsistent. Sets changed if a value was
+    // removed.
+    // effects: board may change
+    //          trail may change
+    //          changed may change
+    bool propagateIntersections(Board& board, Trail &trail, bool &changed) const;
+
+    // Undoes the changes on trail made after its size was mark, most recent
+    // first, and shrinks it back to mark.
+    // effects: board may change
+    //          trail may change
+    void undo(Board& board, Trail &trail, int mark) const;
+
+    // Shared state of a search split over the workers of a ThreadPool.
+    struct ParallelSearch;
+
+    // Subtrees at depths less than this can be handed off to other workers
+    // in a parallel search. Deeper subtrees are too small to be worth it.
+    static const int MAX_SPLIT_DEPTH = 12;
+
+    // Searches for solutions of board, and returns the number found, up to
+    // limit. Once limit solutions are found, board contains the last one.
+    // depth is the number of cells assigned by the search so far. If
+    // parallel isn't null, gives up once another worker finds a solution,
+    // and hands off the subtrees of other values to idle workers near the
+    // root. If backjumping is on, keeps the conflict sets in conflicts, which
+    // are reset first.
+    // The search is iterative, with the frames and the trail on the stack,
+    // so it doesn't recurse or allocate memory. Adds the work done to stats.
+    // Gives up once budget runs out, and returns the solutions found so far.
+    // requires: limit >= 1
+    //           parallel is null or limit == 1
+    //           conflicts isn't null if backjumping is on, and isn't used
+    //           by another search at the same time
+    // effects: board may change
+    //          conflicts may change
+    //          stats may change
+    //          budget may change
+    int search(Board& board, ParallelSearch *parallel, Conflicts *conflicts
+               , int depth, int limit, SearchStats &stats
+               , SearchBudget &budget) const;
+
+    // Runs a subtree handed off in a parallel search and records its
+    // solution, if any.
+    void runSubtree(Board& board, ParallelSearch &parallel, int depth) const;
+
+public:
+    BasicSudokuBacktrack();
+    BasicSudokuBacktrack(const BasicSudokuBacktrack &other);
+    BasicSudokuBacktrack& operator=(const BasicSudokuBacktrack &other);
+    ~BasicSudokuBacktrack();
+
+    inline void setHeuristic(int h) {heuristic = h;}
+    inline void setInference(int i) {inference = i;}
+    inline void setBackjumping(int b) {backjumping = b;}
+
+    // Given a initial partially filled sudoku board, returns true if a
+    // solution exists, false otherwise. If a solution exists, then the board
+    // state will conatin the solution. It will contain garbage values otherwise.
+    // effects: board may change
+    bool solve(Board& board) override;
+
+    // Same as solve, but gives up once limits are reached, see
+    // SudokuSolver::solveWithin.
+    // effects: board may change
+    SolveResult solveWithin(Board& board, const SearchLimits &limits) override;
+
+    // Counts the solutions of board, as in SudokuSolver::countSolutions,
+    // using the same heuristic and inferences as solve.
+    // effects: board may change
+    int countSolutions(Board& board, int limit) override;
+
+    // Same as countSolutions, but gives up once limits are reached, see
+    // SudokuSolver::countWithin.
+    // effects: board may change
+    CountResult countWithin(Board& board, int limit, const SearchLimits &limits) override;
+
+    std::unique_ptr<BasicSudokuSolver<N>> clone() const override;
+
+    // Makes the inferences of the inference flag on board until no more can
+    // be made, without guessing, so a puzzle is solved only if the
+    // inferences are enough, ex. to rate how hard it is. Returns false if
+    // board is found to be inconsistent, true otherwise.
+    // effects: board may change
+    bool deduce(Board& board) const;
+
+    // Returns the stats of the last call to solve, countSolutions,
+    // countWithin, or solveParallel. Always zero unless stats are enabled.
+    inline SearchStats getStats() const override {return stats;}
+
+    // Same as solve, but splits the search tree over the workers of pool.
+    // Subtrees near the root are queued on the pool as other workers become
+    // idle, and all workers stop as soon as one finds a solution. For
+    // puzzles with many solutions, the solution found may differ from the
+    // one found by solve. The stats are summed over every worker.
+    // requires: the caller isn't a worker of pool
+    // effects: board may change
+    bool solveParallel(Board& board, ThreadPool& pool);
+};
+
+// Backtracking search for 9x9 sudoku.
+using SudokuBacktrack = BasicSudokuBacktrack<3>;
@@ -0,0 +1,202 @@
+#include "sudoku_binary.h"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SUDOKU_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define SUDOKU_MMAP 0
+#endif
+
+using namespace std;
+
+namespace {
+    const char MAGIC[4] = {'S', 'U', 'D', 'K'};
+    const int VERSION = 1;
+
+    // Returns the number of bits per cell for box size n.
+    int cellBits(int n) {
+        switch (n) {
+            case 3: return binaryCellBits<3>();
+            case 4: return binaryCellBits<4>();
+            default: return binaryCellBits<5>();
+        }
+    }
+
+    // Returns the size of a record for box size n.
+    size_t recordSize(int n) {
+        switch (n) {
+            case 3: return binaryRecordSize<3>();
+            case 4: return binaryRecordSize<4>();
+            default: return binaryRecordSize<5>();
+        }
+    }
+}
+
+bool isBinaryFormat(const unsigned char *data, size_t size) {
+    return size >= sizeof(MAGIC) && memcmp(data, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+BinaryHeader readBinaryHeader(const unsigned char *data, size_t size) {
+    if (size < BINARY_HEADER_SIZE || !isBinaryFormat(data, size)) {
+        throw runtime_error("Not a binary sudoku file");
+    }
+    if (data[4] != VERSION) {
+        throw runtime_error("Binary sudoku file has unknown version "
+                            + to_string(data[4]));
+    }
+
+    BinaryHeader header;
+    header.boxSize = data[5];
+    if (header.boxSize < 3 || header.boxSize > 5) {
+        throw runtime_error("Binary sudoku file has unsupported box size "
+                            + to_string(header.boxSize));
+    }
+    if (data[6] != cellBits(header.boxSize) || data[7] > 1) {
+        throw runtime_error("Binary sudoku file has a malformed header");
+    }
+    header.solutions = data[7] == 1;
+
+    header.count = 0;
+    for (int i=7; i>=0; --i) {
+        header.count = header.count << 8 | data[8 + i];
+    }
+
+    size_t available = (size - BINARY_HEADER_SIZE) / recordSize(header.boxSize);
+    if (header.count > available) {
+        throw runtime_error("Binary sudoku file has " + to_string(available)
+                            + " records instead of " + to_string(header.count));
+    }
+    return header;
+}
+
+void writeBinaryHeader(ostream &out, const BinaryHeader &header) {
+    unsigned char bytes[BINARY_HEADER_SIZE];
+    memcpy(bytes, MAGIC, sizeof(MAGIC));
+    bytes[4] = VERSION;
+    bytes[5] = static_cast<unsigned char>(header.boxSize);
+    bytes[6] = static_cast<unsigned char>(cellBits(header.boxSize));
+    bytes[7] = header.solutions ? 1 : 0;
+    for (int i=0; i<8; ++i) {
+        bytes[8 + i] = static_cast<unsigned char>(header.count >> (8 * i));
+    }
+    out.write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+}
+
+template <int N>
+void packRecord(const BasicSudoku<N>& board, unsigned char *record) {
+    constexpr int SIZE = BasicSudoku<N>::SIZE;
+    constexpr int BITS = binaryCellBits<N>();
+
+    memset(record, 0, binaryRecordSize<N>());
+    for (int i=0; i<SIZE*SIZE; ++i) {
+        unsigned value = static_cast<unsigned>(board.getCell(i % SIZE, i / SIZE));
+        int bit = i * BITS;
+        record[bit / 8] |= static_cast<unsigned char>(value << (bit % 8));
+        if (bit % 8 + BITS > 8) {
+            record[bit / 8 + 1] |= static_cast<unsigned char>(value >> (8 - bit % 8));
+        }
+    }
+}
+
+template <int N>
+void unpackRecord(const unsigned char *record, BasicSudoku<N>& board) {
+    constexpr int SIZE = BasicSudoku<N>::SIZE;
+    constexpr int BITS = binaryCellBits<N>();
+    constexpr unsigned MASK = (1u << BITS) - 1;
+
+    for (int i=0; i<SIZE*SIZE; ++i) {
+        int bit = i * BITS;
+        unsigned value = record[bit / 8];
+        if (bit % 8 + BITS > 8) value |= static_cast<unsigned>(record[bit / 8 + 1]) << 8;
+        value = (value >> (bit % 8)) & MASK;
+
+        if (value > static_cast<unsigned>(SIZE)) {
+            throw runtime_error("Cell " + to_string(i + 1) + " has value "
+                                + to_string(value) + " that is larger than "
+                                + to_string(SIZE));
+        }
+        board.initCell(i % SIZE, i / SIZE, static_cast<int>(value));
+    }
+}
+
+MappedFile::MappedFile(const string &path) : data(nullptr), size(0) {
+#if SUDOKU_MMAP
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw runtime_error("File " + path + " not found.");
+
+    // Files whose size isn't known are read instead
+    struct stat info{};
+    bool known = fstat(fd, &info) == 0;
+    if (known && info.st_size > 0) {
+        void *mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ
+                             , MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            data = static_cast<const unsigned char*>(mapping);
+            size = static_cast<size_t>(info.st_size);
+            madvise(mapping, size, MADV_SEQUENTIAL);
+        }
+    }
+    close(fd);
+    if (data != nullptr || (known && info.st_size == 0)) return;
+#endif
+
+    // Read the whole file instead
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) throw runtime_error("File " + path + " not found.");
+    contents.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    data = contents.data();
+    size = contents.size();
+}
+
+MappedFile::~MappedFile() {
+#if SUDOKU_MMAP
+    if (contents.empty() && data != nullptr) {
+        munmap(const_cast<unsigned char*>(data), size);
+    }
+#endif
+}
+
+template <int N>
+BasicBinaryReader<N>::BasicBinaryReader(const unsigned char *data, size_t size)
+    : records(data + BINARY_HEADER_SIZE), header(readBinaryHeader(data, size))
+    , index(0) {
+
+    if (header.boxSize != N) {
+        throw runtime_error("Binary sudoku file has box size "
+                            + to_string(header.boxSize) + " instead of "
+                            + to_string(N));
+    }
+}
+
+template <int N>
+bool BasicBinaryReader<N>::next(BasicSudoku<N>& board) {
+    if (index >= header.count) return false;
+
+    const unsigned char *record = records + index * binaryRecordSize<N>();
+    ++index;
+    try {
+        unpackRecord(record, board);
+    } catch (exception &e) {
+        throw runtime_error("Record " + to_string(index) + ": " + e.what());
+    }
+    return true;
+}
+
+template void packRecord(const BasicSudoku<3>&, unsigned char*);
+template void packRecord(const BasicSudoku<4>&, unsigned char*);
+template void packRecord(const BasicSudoku<5>&, unsigned char*);
+
+template void unpackRecord(const unsigned char*, BasicSudoku<3>&);
+template void unpackRecord(const unsigned char*, BasicSudoku<4>&);
+template void unpackRecord(const unsigned char*, BasicSudoku<5>&);
+
+template class BasicBinaryReader<3>;
+template class BasicBinaryReader<4>;
+template class BasicBinaryReader<5>;
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "sudoku_io.h"
+
+// A packed binary format for large collections of sudoku puzzles or
+// solutions, read without parsing. A file is a 16 byte header followed by
+// one fixed size record per puzzle.
+//
+// Header, with numbers in little endian:
+//     bytes 0-3   "SUDK"
+//     byte  4     format version, 1
+//     byte  5     box size N, 3 for 9x9 sudoku
+//     byte  6     bits per cell, 4 for 9x9 sudoku and 5 for larger sudoku
+//     byte  7     0 for puzzles, 1 for solutions
+//     bytes 8-15  number of records
+//
+// A record holds the cells row by row, packed from the lowest bit of each
+// byte up, with 0 for empty cells. A 9x9 record is 81 cells of 4 bits, 41
+// bytes. In a file of solutions, a record of empty cells means the puzzle
+// had no solution.
+
+// Size of the header, in bytes.
+const std::size_t BINARY_HEADER_SIZE = 16;
+
+// Returns the number of bits per cell in a record.
+template <int N>
+constexpr int binaryCellBits() {
+    return N * N < 16 ? 4 : 5;
+}
+
+// Returns the size of a record, in bytes.
+template <int N>
+constexpr std::size_t binaryRecordSize() {
+    return (static_cast<std::size_t>(N*N*N*N) * binaryCellBits<N>() + 7) / 8;
+}
+
+// The header of a binary file.
+struct BinaryHeader {
+    int boxSize = 3;
+    bool solutions = false;
+    std::uint64_t count = 0;
+};
+
+// Returns true if data starts with the magic bytes of a binary file.
+bool isBinaryFormat(const unsigned char *data, std::size_t size);
+
+// Parses the header at data. Throws runtime_error if it isn't a valid
+// header, or the data doesn't hold as many records as the header says.
+BinaryHeader readBinaryHeader(const unsigned char *data, std::size_t size);
+
+// Writes the header to out.
+// effects: writes to out
+void writeBinaryHeader(std::ostream &out, const BinaryHeader &header);
+
+// Packs the cells of board into record.
+// requires: record has binaryRecordSize<N>() bytes
+template <int N>
+void packRecord(const BasicSudoku<N>& board, unsigned char *record);
+
+// Sets the cells of board from record. Throws runtime_error if a cell has a
+// value larger than SIZE.
+// requires: board is a newly constructed BasicSudoku
+// effects: board may change
+template <int N>
+void unpackRecord(const unsigned char *record, BasicSudoku<N>& board);
+
+// MappedFile maps a whole file into memory, read only, so it can be read
+// without copying. Falls back to reading the file into memory where mmap
+// isn't available.
+class MappedFile {
+    const unsigned char *data;
+    std::size_t size;
+
+    // Contents of the file if it couldn't be mapped.
+    std::vector<unsigned char> contents;
+
+public:
+    // Maps the file at path. Throws runtime_error if it can't be opened.
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    inline const unsigned char *getData() const {
+        return data;
+    }
+
+    inline std::size_t getSize() const {
+        return size;
+    }
+};
+
+// BasicBinaryReader reads the puzzles of a binary file with N by N boxes
+// straight from memory, ex. from a MappedFile.
+template <int N>
+class BasicBinaryReader : public BasicPuzzleSource<N> {
+    const unsigned char *records;
+    BinaryHeader header;
+
+    // Index of the next record.
+    std::uint64_t index;
+
+public:
+    // Reads the records of the binary file at data, which must stay valid
+    // while reading. Throws runtime_error if the header is malformed, or is
+    // for another box size.
+    BasicBinaryReader(const unsigned char *data, std::size_t size);
+
+    // Reads the next puzzle into board, as in BasicPuzzleSource::next.
+    // Returns false after the last record.
+    // requires: board is a newly constructed BasicSudoku
+    // effects: board may change
+    bool next(BasicSudoku<N>& board) override;
+
+    inline const BinaryHeader& getHeader() const {
+        return header;
+    }
+};
+
+// Reads binary files of 9x9 sudoku.
+using BinaryReader = BasicBinaryReader<3>;
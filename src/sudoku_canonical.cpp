@@ -0,0 +1,272 @@
+#include "sudoku_canonical.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+    template <int N>
+    using Permutation = array<uint8_t, N>;
+
+    // Returns every permutation of 0 to N-1, in increasing order.
+    template <int N>
+    const vector<Permutation<N>>& permutations() {
+        static const vector<Permutation<N>> perms = [] {
+            vector<Permutation<N>> result;
+            Permutation<N> perm;
+            for (int i=0; i<N; ++i) perm[i] = static_cast<uint8_t>(i);
+            do {
+                result.push_back(perm);
+            } while (next_permutation(perm.begin(), perm.end()));
+            return result;
+        }();
+        return perms;
+    }
+}
+
+template <int N>
+BasicCanonicalForm<N>::BasicCanonicalForm() : key(NUM_CELLS, '\0') {}
+
+template <int N>
+bool BasicCanonicalForm<N>::compute(const BasicSudoku<N>& board) {
+    for (int y=0; y<SIZE; ++y) {
+        for (int x=0; x<SIZE; ++x) {
+            int value = board.getCell(x, y);
+            if (value != 0 && !board.isConsistent(x, y, value)) return false;
+
+            grids[0][y*SIZE + x] = static_cast<uint8_t>(value);
+            grids[1][x*SIZE + y] = static_cast<uint8_t>(value);
+        }
+    }
+
+    candidates.clear();
+    findFirstRows();
+    for (int row=1; row<SIZE; ++row) {
+        findRow(row);
+    }
+
+    // Every candidate left gives the same puzzle
+    best = candidates[0];
+
+    // Give the values missing from the puzzle the unused labels, in order
+    for (int value=1; value<=SIZE; ++value) {
+        if (best.labels[value] == 0) {
+            best.labels[value] = static_cast<uint8_t>(++best.numLabels);
+        }
+    }
+    values[0] = 0;
+    for (int value=1; value<=SIZE; ++value) {
+        values[best.labels[value]] = static_cast<uint8_t>(value);
+    }
+
+    const auto &grid = grids[best.grid];
+    for (int row=0; row<SIZE; ++row) {
+        for (int col=0; col<SIZE; ++col) {
+            key[row*SIZE + col] = static_cast<char>(
+                best.labels[grid[best.rows[row]*SIZE + best.columns[col]]]);
+        }
+    }
+    return true;
+}
+
+template <int N>
+void BasicCanonicalForm<N>::findFirstRows() {
+    const auto &perms = permutations<N>();
+
+    // Since filled cells don't break rules, the filled cells of the first
+    // row get labels 1, 2, 3, ... from left to right, so the smallest first
+    // row is the one with the most empty cells on the left. That puts the
+    // stacks with the fewest filled cells first, and the empty cells of
+    // every stack first.
+    Line smallest;
+    smallest.fill(2);
+
+    for (int g=0; g<2; ++g) {
+        for (int y=0; y<SIZE; ++y) {
+            const uint8_t *cells = &grids[g][y*SIZE];
+
+            array<int, N> counts{};
+            for (int x=0; x<SIZE; ++x) {
+                if (cells[x] != 0) ++counts[x / N];
+            }
+
+            // Row of 0 for empty cells and 1 for filled cells
+            array<int, N> sorted = counts;
+            sort(sorted.begin(), sorted.end());
+            Line pattern;
+            for (int s=0; s<N; ++s) {
+                for (int k=0; k<N; ++k) {
+                    pattern[s*N + k] = k >= N - sorted[s];
+                }
+            }
+
+            if (pattern > smallest) continue;
+            if (pattern < smallest) {
+                smallest = pattern;
+                candidates.clear();
+            }
+
+            // Orders of the stacks with the fewest filled cells first
+            vector<const Permutation<N>*> stackOrders;
+            for (const auto &perm : perms) {
+                bool sortedStacks = true;
+                for (int s=1; s<N; ++s) {
+                    if (counts[perm[s-1]] > counts[perm[s]]) sortedStacks = false;
+                }
+                if (sortedStacks) stackOrders.push_back(&perm);
+            }
+
+            // Orders of the columns of every stack with the empty cells first
+            array<vector<const Permutation<N>*>, N> columnOrders;
+            for (int s=0; s<N; ++s) {
+                for (const auto &perm : perms) {
+                    bool emptyFirst = true;
+                    for (int k=1; k<N; ++k) {
+                        if (cells[s*N + perm[k-1]] != 0 && cells[s*N + perm[k]] == 0) {
+                            emptyFirst = false;
+                        }
+                    }
+                    if (emptyFirst) columnOrders[s].push_back(&perm);
+                }
+            }
+
+            Candidate candidate;
+            candidate.grid = g;
+            candidate.rows[0] = static_cast<uint8_t>(y);
+            candidate.usedRows = 1u << y;
+            candidate.usedBands = 1u << (y / N);
+
+            for (const Permutation<N> *stacks : stackOrders) {
+                // Count through every choice of column order of every stack
+                array<size_t, N> choice{};
+                while (true) {
+                    if (candidates.size() >= static_cast<size_t>(MAX_CANDIDATES)) break;
+
+                    candidate.labels.fill(0);
+                    candidate.numLabels = 0;
+                    for (int s=0; s<N; ++s) {
+                        int stack = (*stacks)[s];
+                        const Permutation<N> &columns = *columnOrders[stack][choice[s]];
+                        for (int k=0; k<N; ++k) {
+                            int x = stack*N + columns[k];
+                            candidate.columns[s*N + k] = static_cast<uint8_t>(x);
+                            if (cells[x] != 0) {
+                                candidate.labels[cells[x]] = static_cast<uint8_t>(++candidate.numLabels);
+                            }
+                        }
+                    }
+                    candidates.push_back(candidate);
+
+                    int s = N - 1;
+                    for (; s >= 0; --s) {
+                        if (++choice[s] < columnOrders[(*stacks)[s]].size()) break;
+                        choice[s] = 0;
+                    }
+                    if (s < 0) break;
+                }
+            }
+        }
+    }
+}
+
+template <int N>
+void BasicCanonicalForm<N>::findRow(int row) {
+    next.clear();
+
+    Line smallest;
+    Line line;
+    Labels labels;
+    bool found = false;
+
+    for (const Candidate &candidate : candidates) {
+        const auto &grid = grids[candidate.grid];
+
+        // The first row of a band can come from any band not used yet, the
+        // others from the same band as the first
+        int firstBand = 0;
+        int lastBand = N - 1;
+        if (row % N != 0) {
+            firstBand = lastBand = candidate.rows[row - row % N] / N;
+        }
+
+        for (int band = firstBand; band <= lastBand; ++band) {
+            if (row % N == 0 && (candidate.usedBands >> band & 1) != 0) continue;
+
+            for (int y = band*N; y < band*N + N; ++y) {
+                if ((candidate.usedRows >> y & 1) != 0) continue;
+
+                // Relabel the row, giving new values the next labels. Stop
+                // as soon as the row is larger than the smallest row.
+                labels = candidate.labels;
+                int numLabels = candidate.numLabels;
+                const uint8_t *cells = &grid[y*SIZE];
+                int cmp = found ? 0 : -1;
+                for (int col=0; col<SIZE && cmp <= 0; ++col) {
+                    int value = cells[candidate.columns[col]];
+                    if (value != 0 && labels[value] == 0) {
+                        labels[value] = static_cast<uint8_t>(++numLabels);
+                    }
+                    line[col] = labels[value];
+                    if (cmp == 0 && line[col] != smallest[col]) {
+                        cmp = line[col] < smallest[col] ? -1 : 1;
+                    }
+                }
+
+                if (cmp > 0) continue;
+                if (cmp < 0) {
+                    smallest = line;
+                    found = true;
+                    next.clear();
+                }
+                if (next.size() >= static_cast<size_t>(MAX_CANDIDATES)) continue;
+
+                next.push_back(candidate);
+                Candidate &kept = next.back();
+                kept.rows[row] = static_cast<uint8_t>(y);
+                kept.usedRows |= 1u << y;
+                kept.usedBands |= 1u << band;
+                kept.labels = labels;
+                kept.numLabels = numLabels;
+            }
+        }
+    }
+
+    swap(candidates, next);
+}
+
+template <int N>
+void BasicCanonicalForm<N>::toCanonical(const BasicSudoku<N>& board
+                                        , string &cells) const {
+    cells.resize(NUM_CELLS);
+    for (int row=0; row<SIZE; ++row) {
+        for (int col=0; col<SIZE; ++col) {
+            int x = best.columns[col];
+            int y = best.rows[row];
+            int value = best.grid == 0 ? board.getCell(x, y) : board.getCell(y, x);
+            cells[row*SIZE + col] = static_cast<char>(best.labels[value]);
+        }
+    }
+}
+
+template <int N>
+void BasicCanonicalForm<N>::fromCanonical(const string &cells
+                                          , BasicSudoku<N>& board) const {
+    assert(cells.size() == static_cast<size_t>(NUM_CELLS));
+
+    for (int row=0; row<SIZE; ++row) {
+        for (int col=0; col<SIZE; ++col) {
+            int x = best.columns[col];
+            int y = best.rows[row];
+            int value = values[static_cast<uint8_t>(cells[row*SIZE + col])];
+            if (best.grid == 0) {
+                board.setCell(x, y, value);
+            } else {
+                board.setCell(y, x, value);
+            }
+        }
+    }
+}
+
+template class BasicCanonicalForm<3>;
+template class BasicCanonicalForm<4>;
+template class BasicCanonicalForm<5>;
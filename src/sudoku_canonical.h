@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "sudoku.h"
+
+// BasicCanonicalForm finds the canonical form of a sudoku puzzle with N by
+// N boxes, the same for every puzzle that is a relabeling or a rearrangement
+// of it. Rearrangements that keep the rules are transposing the board,
+// reordering the bands of N rows, the rows within a band, the stacks of N
+// columns, and the columns within a stack. The canonical form is the
+// rearranged and relabeled puzzle that is smallest when read row by row,
+// with 0 for empty cells, the usual "minlex" form.
+//
+// The search goes row by row and only keeps the rearrangements that give
+// the smallest rows so far. Puzzles with many symmetries, like nearly empty
+// or large boards, can tie on a very large number of rearrangements, so at
+// most MAX_CANDIDATES are kept. The form of such a puzzle is still a
+// rearrangement of it, but another rearrangement of the same puzzle may get
+// a different form.
+//
+// The form remembers the rearrangement and relabeling, to move a solution
+// of the canonical puzzle back to the original puzzle. Its working memory
+// is reused between puzzles, so one form shouldn't be used from multiple
+// threads at once.
+template <int N>
+class BasicCanonicalForm {
+public:
+    static constexpr int SIZE = BasicSudoku<N>::SIZE;
+    static constexpr int NUM_CELLS = BasicSudoku<N>::NUM_CELLS;
+
+    // Most rearrangements kept while searching.
+    static constexpr int MAX_CANDIDATES = 1 << 12;
+
+private:
+    using Line = std::array<std::uint8_t, SIZE>;
+    using Labels = std::array<std::uint8_t, SIZE + 1>;
+
+    // A rearrangement whose first rows are the smallest found so far.
+    struct Candidate {
+        // Index of the grid in grids, 1 if the board is transposed.
+        int grid;
+
+        // Row and column of the grid placed at every row and column of the
+        // canonical puzzle. Only the first rows are set while searching.
+        Line rows;
+        Line columns;
+
+        // Rows and bands of the grid already placed, one bit each.
+        std::uint32_t usedRows;
+        std::uint32_t usedBands;
+
+        // Canonical label of every value, 0 if the value hasn't been seen
+        // yet.
+        Labels labels;
+        int numLabels;
+    };
+
+    // The cells of the board, row by row, and of the transposed board.
+    std::array<std::array<std::uint8_t, NUM_CELLS>, 2> grids;
+
+    // Rearrangements being searched, and the ones kept for the next row.
+    std::vector<Candidate> candidates;
+    std::vector<Candidate> next;
+
+    // The canonical puzzle, one char per cell value, row by row.
+    std::string key;
+
+    // The rearrangement and relabeling that gives key, and the value of
+    // every canonical label.
+    Candidate best;
+    Labels values;
+
+    // Adds the rearrangements of the first row that give the smallest first
+    // row to candidates.
+    void findFirstRows();
+
+    // Keeps the candidates whose row number row is the smallest, trying
+    // every row of the grid that can go there.
+    void findRow(int row);
+
+public:
+    BasicCanonicalForm();
+
+    // Finds the canonical form of board. Returns false if the filled cells
+    // of board break a rule, since they have no solution, true otherwise.
+    bool compute(const BasicSudoku<N>& board);
+
+    // Returns the canonical puzzle of the last board computed, one char per
+    // cell value, row by row. Equal for puzzles that are rearrangements of
+    // each other.
+    inline const std::string& getKey() const {
+        return key;
+    }
+
+    // Stores board rearranged and relabeled like the last board computed in
+    // cells, one char per cell value, row by row.
+    void toCanonical(const BasicSudoku<N>& board, std::string &cells) const;
+
+    // Sets every cell of board from cells, the inverse of toCanonical. Used
+    // to move a solution of the canonical puzzle to the original puzzle.
+    // requires: cells.size() == NUM_CELLS, with values from 0 to SIZE
+    // effects: board changes
+    void fromCanonical(const std::string &cells, BasicSudoku<N>& board) const;
+};
+
+// Canonical form of 9x9 sudoku.
+using CanonicalForm = BasicCanonicalForm<3>;
@@ -0,0 +1,56 @@
+#include "sudoku_context.h"
+#include <cassert>
+#include <stdexcept>
+#include <string>
+#include "sudoku_backtrack.h"
+using namespace std;
+
+template <int N>
+BasicSudokuContext<N>::BasicSudokuContext() {
+    auto backtrack = make_unique<BasicSudokuBacktrack<N>>();
+    backtrack->setHeuristic(3);
+    backtrack->setInference(1);
+    solver = move(backtrack);
+}
+
+template <int N>
+BasicSudokuContext<N>::BasicSudokuContext(unique_ptr<BasicSudokuSolver<N>> solver)
+    : solver(move(solver)) {
+    assert(this->solver);
+}
+
+template <int N>
+void BasicSudokuContext<N>::load(const uint8_t *puzzle) {
+    for (int i=0; i<NUM_CELLS; ++i) {
+        if (puzzle[i] > SIZE) {
+            throw runtime_error("Cell " + to_string(i + 1) + " has value "
+                                + to_string(puzzle[i]) + " that is larger than "
+                                + to_string(SIZE));
+        }
+    }
+    board.loadCells(puzzle);
+}
+
+template <int N>
+SolveResult BasicSudokuContext<N>::solve(const uint8_t *puzzle, uint8_t *solution
+                                         , const SearchLimits &limits) {
+    load(puzzle);
+
+    SolveResult result = solver->solveWithin(board, limits);
+    if (result == SolveResult::Solved) board.storeCells(solution);
+    return result;
+}
+
+template <int N>
+int BasicSudokuContext<N>::countSolutions(const uint8_t *puzzle, int limit
+                                          , uint8_t *solution) {
+    load(puzzle);
+
+    int count = solver->countSolutions(board, limit);
+    if (count == limit && solution != nullptr) board.storeCells(solution);
+    return count;
+}
+
+template class BasicSudokuContext<3>;
+template class BasicSudokuContext<4>;
+template class BasicSudokuContext<5>;
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include "sudoku_solver.h"
+
+// BasicSudokuContext solves sudoku puzzles with N by N boxes given as plain
+// arrays of cells, for programs that embed the solver instead of reading
+// puzzle files. Cells are given row by row, SIZE*SIZE of them, with 0 for
+// empty cells and 1 to SIZE for filled cells.
+//
+// A context keeps its solver and board between calls, so solving another
+// puzzle with the same context allocates no memory, unless the solver
+// itself allocates, like the portfolio. Like the solvers, one context
+// shouldn't be used from multiple threads at once, so use one context per
+// thread.
+template <int N>
+class BasicSudokuContext {
+public:
+    static constexpr int SIZE = BasicSudoku<N>::SIZE;
+    static constexpr int NUM_CELLS = BasicSudoku<N>::NUM_CELLS;
+
+private:
+    std::unique_ptr<BasicSudokuSolver<N>> solver;
+    BasicSudoku<N> board;
+
+    // Loads puzzle into board. Throws runtime_error if a cell is larger
+    // than SIZE.
+    void load(const std::uint8_t *puzzle);
+
+public:
+    // Creates a context that solves with backtracking, using the
+    // heuristic and inference that are fastest on most puzzles.
+    BasicSudokuContext();
+
+    // Creates a context that solves with solver.
+    // requires: solver != nullptr
+    explicit BasicSudokuContext(std::unique_ptr<BasicSudokuSolver<N>> solver);
+
+    // Solves puzzle within limits, see BasicSudokuSolver::solveWithin. If
+    // the result is Solved, writes the solution to solution in the same
+    // order as puzzle, and leaves solution unchanged otherwise. puzzle and
+    // solution may be the same array. Throws runtime_error if a cell of
+    // puzzle is larger than SIZE.
+    // requires: puzzle has NUM_CELLS cells
+    //           solution has room for NUM_CELLS cells
+    SolveResult solve(const std::uint8_t *puzzle, std::uint8_t *solution
+                      , const SearchLimits &limits = SearchLimits());
+
+    // Returns the number of solutions of puzzle, counting up to limit, see
+    // BasicSudokuSolver::countSolutions. If limit solutions are found and
+    // solution isn't null, writes the last one to solution. Throws
+    // runtime_error if a cell of puzzle is larger than SIZE.
+    // requires: puzzle has NUM_CELLS cells
+    //           solution is null, or has room for NUM_CELLS cells
+    int countSolutions(const std::uint8_t *puzzle, int limit
+                       , std::uint8_t *solution = nullptr);
+
+    // Returns the solver, ex. for its stats.
+    inline BasicSudokuSolver<N>& getSolver() {
+        return *solver;
+    }
+};
+
+// Context for 9x9 sudoku, solving cells of a uint8_t[81].
+using SudokuContext = BasicSudokuContext<3>;
@@ -0,0 +1,212 @@
+#include "sudoku_dlx.h"
+
+using namespace std;
+
+namespace {
+    // Returns the row of the exact cover matrix for placing value at (x, y).
+    inline int rowIndex(int x, int y, int value) {
+        return (y*9 + x)*9 + value-1;
+    }
+}
+
+SudokuDLX::SudokuDLX()
+    : left(NUM_NODES), right(NUM_NODES), up(NUM_NODES), down(NUM_NODES)
+    , column(NUM_NODES), size(NUM_COLUMNS + 1), numChosen(0) {
+
+    // Link the root and column headers in a circular list, with empty
+    // columns.
+    for (int c=0; c<=NUM_COLUMNS; ++c) {
+        left[c] = (c == 0) ? NUM_COLUMNS : c-1;
+        right[c] = (c == NUM_COLUMNS) ? 0 : c+1;
+        up[c] = c;
+        down[c] = c;
+        column[c] = c;
+        size[c] = 0;
+    }
+
+    // Append the 4 nodes of each row to the bottom of their columns
+    for (int y=0; y<9; ++y) {
+        for (int x=0; x<9; ++x) {
+            for (int value=1; value<=9; ++value) {
+                int box = y/3*3 + x/3;
+                int d = value-1;
+
+                // Column headers of the 4 constraints, starting at 1
+                int headers[4] = {
+                    1 + y*9 + x,
+                    1 + 81 + y*9 + d,
+                    1 + 2*81 + x*9 + d,
+                    1 + 3*81 + box*9 + d
+                };
+
+                int first = FIRST_NODE + 4 * rowIndex(x, y, value);
+                for (int i=0; i<4; ++i) {
+                    int node = first + i;
+                    int c = headers[i];
+
+                    left[node] = first + (i+3) % 4;
+                    right[node] = first + (i+1) % 4;
+
+                    up[node] = up[c];
+                    down[node] = c;
+                    down[up[c]] = node;
+                    up[c] = node;
+
+                    column[node] = c;
+                    ++size[c];
+                }
+            }
+        }
+    }
+}
+
+void SudokuDLX::cover(int c) {
+    right[left[c]] = right[c];
+    left[right[c]] = left[c];
+
+    for (int i = down[c]; i != c; i = down[i]) {
+        for (int j = right[i]; j != i; j = right[j]) {
+            down[up[j]] = down[j];
+            up[down[j]] = up[j];
+            --size[column[j]];
+        }
+    }
+}
+
+void SudokuDLX::uncover(int c) {
+    for (int i = up[c]; i != c; i = up[i]) {
+        for (int j = left[i]; j != i; j = left[j]) {
+            ++size[column[j]];
+            down[up[j]] = j;
+            up[down[j]] = j;
+        }
+    }
+
+    right[left[c]] = c;
+    left[right[c]] = c;
+}
+
+void SudokuDLX::chooseRow(int node) {
+    cover(column[node]);
+    for (int j = right[node]; j != node; j = right[j]) {
+        cover(column[j]);
+    }
+}
+
+void SudokuDLX::unchooseRow(int node) {
+    for (int j = left[node]; j != node; j = left[j]) {
+        uncover(column[j]);
+    }
+    uncover(column[node]);
+}
+
+int SudokuDLX::search(int limit) {
+    // Every constraint is covered
+    if (right[0] == 0) return 1;
+
+    // Choose the column with the fewest rows left
+    int best = right[0];
+    for (int c = right[best]; c != 0; c = right[c]) {
+        if (size[c] < size[best]) {
+            best = c;
+            if (size[c] <= 1) break;
+        }
+    }
+    if (size[best] == 0) return 0;
+
+    cover(best);
+
+    // Try every row in the column
+    int count = 0;
+    for (int i = down[best]; i != best; i = down[i]) {
+        if (budget->spend()) break;
+        chosen[numChosen++] = i;
+
+        for (int j = right[i]; j != i; j = right[j]) {
+            cover(column[j]);
+        }
+
+        count += search(limit - count);
+        if (count == limit) return count;
+
+        for (int j = left[i]; j != i; j = left[j]) {
+            uncover(column[j]);
+        }
+        --numChosen;
+    }
+
+    uncover(best);
+    return count;
+}
+
+bool SudokuDLX::solve(Sudoku& board) {
+    SearchBudget unlimited;
+    return run(board, 1, unlimited) == 1;
+}
+
+SolveResult SudokuDLX::solveWithin(Sudoku& board, const SearchLimits &limits) {
+    SearchBudget limited(&limits);
+    if (run(board, 1, limited) == 1) return SolveResult::Solved;
+    return limited.isStopped() ? limited.getReason() : SolveResult::Unsolvable;
+}
+
+int SudokuDLX::countSolutions(Sudoku& board, int limit) {
+    if (limit <= 0) return 0;
+    SearchBudget unlimited;
+    return run(board, limit, unlimited);
+}
+
+CountResult SudokuDLX::countWithin(Sudoku& board, int limit, const SearchLimits &limits) {
+    if (limit <= 0) return CountResult();
+    SearchBudget limited(&limits);
+    int count = run(board, limit, limited);
+    return makeCountResult(count, limit, limited);
+}
+
+int SudokuDLX::run(Sudoku& board, int limit, SearchBudget &budget) {
+    numChosen = 0;
+    this->budget = &budget;
+
+    // Choose the rows of the initially filled cells. Filled cells that
+    // break the rules conflict with a row chosen before.
+    bool consistent = true;
+    for (int y=0; y<9 && consistent; ++y) {
+        for (int x=0; x<9; ++x) {
+            int value = board.getCell(x, y);
+            if (value == 0) continue;
+
+            int first = FIRST_NODE + 4 * rowIndex(x, y, value);
+            for (int i=0; i<4; ++i) {
+                if (!isUncovered(column[first + i])) consistent = false;
+            }
+            if (!consistent) break;
+
+            chooseRow(first);
+            chosen[numChosen++] = first;
+        }
+    }
+
+    int count = consistent ? search(limit) : 0;
+
+    // Write the last solution found
+    if (count == limit) {
+        for (int i=0; i<numChosen; ++i) {
+            int r = (chosen[i] - FIRST_NODE) / 4;
+            int cell = r / 9;
+            board.setCell(cell % 9, cell / 9, r % 9 + 1);
+        }
+    }
+
+    // Restore the matrix for the next puzzle, in reverse order
+    for (int i = numChosen-1; i >= 0; --i) {
+        unchooseRow(chosen[i]);
+    }
+    numChosen = 0;
+    this->budget = nullptr;
+
+    return count;
+}
+
+unique_ptr<SudokuSolver> SudokuDLX::clone() const {
+    return make_unique<SudokuDLX>();
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include "sudoku.h"
+#include "sudoku_solver.h"
+
+// SudokuDLX solves sudoku puzzles as an exact cover problem with Knuth's
+// Algorithm X, using dancing links. See https://arxiv.org/abs/cs/0011047
+//
+// Each row of the exact cover matrix is an option of placing a value in a
+// cell, 9x9x9 = 729 rows. Each column is a constraint that must be covered
+// exactly once, 4x81 = 324 columns:
+// - every cell has a value
+// - every row has every value
+// - every column has every value
+// - every 3x3 subgrid has every value
+// Every option covers one constraint of each kind, so the matrix has 4
+// nodes per row.
+//
+// Nodes are stored in flat arrays and linked by index. The matrix is built
+// once, and every search restores it, so it is reused between puzzles.
+class SudokuDLX : public SudokuSolver {
+    static const int NUM_COLUMNS = 4 * 81;
+    static const int NUM_ROWS = 9 * 81;
+
+    // Node 0 is the root, nodes 1 to NUM_COLUMNS are column headers, and
+    // the 4 nodes of row r are FIRST_NODE + 4*r to FIRST_NODE + 4*r + 3.
+    static const int FIRST_NODE = NUM_COLUMNS + 1;
+    static const int NUM_NODES = FIRST_NODE + 4 * NUM_ROWS;
+
+    // Links of each node to its neighbours in the same row (left, right)
+    // and column (up, down).
+    std::vector<int> left;
+    std::vector<int> right;
+    std::vector<int> up;
+    std::vector<int> down;
+
+    // Column header of each node.
+    std::vector<int> column;
+
+    // Number of uncovered rows in each column, indexed by column header.
+    std::vector<int> size;
+
+    // Rows chosen so far, one per filled cell. Each row is stored as the
+    // node that chose it, the first node of the row for filled cells of the
+    // initial board, or the node in the column covered by search otherwise.
+    std::array<int, 81> chosen;
+    int numChosen;
+
+    // Budget of the running search, see search.
+    SearchBudget *budget = nullptr;
+
+    // Removes column c from the header list, and removes every row that
+    // covers c from the other columns.
+    void cover(int c);
+
+    // Reverts cover(c). Columns must be uncovered in reverse order.
+    void uncover(int c);
+
+    // Returns true if column c is in the header list.
+    inline bool isUncovered(int c) const {
+        return right[left[c]] == c;
+    }
+
+    // Chooses the row of node, covering every column in it, starting with
+    // the column of node.
+    void chooseRow(int node);
+
+    // Reverts chooseRow(node).
+    void unchooseRow(int node);
+
+    // Searches for sets of rows that cover the uncovered columns, and
+    // returns the number found, up to limit. Once limit sets are found,
+    // leaves the rows of the last one in chosen and their columns covered.
+    // Otherwise, the matrix is left as it was. Gives up once budget runs
+    // out, and returns the sets found so far.
+    // requires: limit >= 1
+    //           budget isn't null
+    int search(int limit);
+
+    // Chooses the rows of the filled cells of board, searches for up to
+    // limit solutions, and writes the last one found to board if limit were
+    // found. Restores the matrix afterwards. Returns the number of solutions
+    // found. Gives up once budget runs out.
+    // effects: board may change
+    //          budget may change
+    int run(Sudoku& board, int limit, SearchBudget &budget);
+
+public:
+    SudokuDLX();
+
+    // Given a initial partially filled sudoku board, returns true if a
+    // solution exists, false otherwise. If a solution exists, then the board
+    // state will conatin the solution. The board is unchanged otherwise.
+    // effects: board may change
+    bool solve(Sudoku& board) override;
+
+    // Same as solve, but gives up once limits are reached, see
+    // SudokuSolver::solveWithin. The board is unchanged unless solved.
+    // effects: board may change
+    SolveResult solveWithin(Sudoku& board, const SearchLimits &limits) override;
+
+    int countSolutions(Sudoku& board, int limit) override;
+
+    // Same as countSolutions, but gives up once limits are reached, see
+    // SudokuSolver::countWithin.
+    // effects: board may change
+    CountResult countWithin(Sudoku& board, int limit, const SearchLimits &limits) override;
+
+    std::unique_ptr<SudokuSolver> clone() const override;
+};
@@ -0,0 +1,154 @@
+#include "sudoku_generator.h"
+#include <algorithm>
+using namespace std;
+
+namespace {
+    // Returns x with its bits mixed, the finalizer of splitmix64, so
+    // nearby seeds and puzzle numbers give unrelated random sequences.
+    uint64_t mix(uint64_t x) {
+        x += 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    // Returns a random integer in [0, n) from rng. Unlike the standard
+    // distributions, the sequence is the same with every standard library,
+    // so a seed gives the same puzzles everywhere.
+    int randomInt(mt19937_64 &rng, int n) {
+        return static_cast<int>(rng() % static_cast<uint64_t>(n));
+    }
+
+    // Shuffles values with rng, see randomInt.
+    // effects: values may change
+    template <typename T, size_t N>
+    void shuffle(array<T, N> &values, mt19937_64 &rng) {
+        for (int i = static_cast<int>(N) - 1; i > 0; --i) {
+            swap(values[i], values[randomInt(rng, i + 1)]);
+        }
+    }
+}
+
+template <int N>
+BasicGenerator<N>::BasicGenerator() {
+    solver.setHeuristic(3);
+    solver.setInference(1);
+    singles.setHeuristic(3);
+    singles.setInference(1);
+    pairs.setHeuristic(3);
+    pairs.setInference(2);
+}
+
+template <int N>
+void BasicGenerator<N>::fill(mt19937_64 &rng, Cells &grid) {
+    // A few searches from the random boxes go deep before finding a
+    // solution, so they're given up for new boxes
+    SearchLimits limits;
+    limits.maxNodes = 4 * NUM_CELLS;
+
+    while (true) {
+        // The boxes on the diagonal share no row, column, or box, so any
+        // values fit
+        grid.fill(0);
+        for (int box=0; box<N; ++box) {
+            array<uint8_t, SIZE> values;
+            for (int i=0; i<SIZE; ++i) values[i] = static_cast<uint8_t>(i + 1);
+            shuffle(values, rng);
+
+            for (int i=0; i<SIZE; ++i) {
+                int x = box*N + i%N;
+                int y = box*N + i/N;
+                grid[y*SIZE + x] = values[i];
+            }
+        }
+
+        board.loadCells(grid.data());
+        if (solver.solveWithin(board, limits) == SolveResult::Solved) {
+            board.storeCells(grid.data());
+            return;
+        }
+    }
+}
+
+template <int N>
+bool BasicGenerator<N>::isUnique(const Cells &cells, int cell, int value) {
+    board.loadCells(cells.data());
+    board.removeValue(BasicSudoku<N>::cellIndex(cell % SIZE, cell / SIZE), value);
+
+    SearchLimits limits;
+    limits.maxNodes = maxNodes;
+    return solver.solveWithin(board, limits) == SolveResult::Unsolvable;
+}
+
+template <int N>
+bool BasicGenerator<N>::attempt(mt19937_64 &rng, Cells &puzzle, Cells &solution) {
+    fill(rng, solution);
+    puzzle = solution;
+
+    array<int, NUM_CELLS> order;
+    for (int i=0; i<NUM_CELLS; ++i) order[i] = i;
+    shuffle(order, rng);
+
+    // Removing a clue never makes a puzzle easier, so removals that make it
+    // harder than an easy or medium target are undone right away
+    bool rateRemovals = difficulty == Difficulty::Easy || difficulty == Difficulty::Medium;
+
+    int clues = NUM_CELLS;
+    for (int cell : order) {
+        if (clues <= numClues) break;
+
+        uint8_t value = puzzle[cell];
+        puzzle[cell] = 0;
+
+        bool removed = isUnique(puzzle, cell, value);
+        if (removed && rateRemovals) {
+            board.loadCells(puzzle.data());
+            removed = rate(board) <= difficulty;
+        }
+
+        if (removed) {
+            --clues;
+        } else {
+            puzzle[cell] = value;
+        }
+    }
+
+    if (numClues > 0 && clues > numClues) return false;
+    if (difficulty != Difficulty::Any) {
+        board.loadCells(puzzle.data());
+        if (rate(board) != difficulty) return false;
+    }
+    return true;
+}
+
+template <int N>
+Difficulty BasicGenerator<N>::rate(const BasicSudoku<N>& puzzle) const {
+    BasicSudoku<N> copy = puzzle;
+    if (singles.deduce(copy) && copy.getNumEmptyCells() == 0) return Difficulty::Easy;
+
+    copy = puzzle;
+    if (pairs.deduce(copy) && copy.getNumEmptyCells() == 0) return Difficulty::Medium;
+
+    return Difficulty::Hard;
+}
+
+template <int N>
+int BasicGenerator<N>::generate(uint64_t seed, uint64_t index, uint8_t *puzzle
+                                , uint8_t *solution) {
+    mt19937_64 rng(mix(mix(seed) + index));
+
+    Cells puzzleCells;
+    Cells solutionCells;
+    for (int i=1; i<=maxAttempts; ++i) {
+        if (attempt(rng, puzzleCells, solutionCells)) {
+            copy(puzzleCells.begin(), puzzleCells.end(), puzzle);
+            copy(solutionCells.begin(), solutionCells.end(), solution);
+            return i;
+        }
+    }
+    return 0;
+}
+
+template class BasicGenerator<3>;
+template class BasicGenerator<4>;
+template class BasicGenerator<5>;
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include "sudoku_backtrack.h"
+
+// How hard a puzzle with a unique solution is to solve, by the inferences
+// it takes, see BasicSudokuBacktrack.
+enum class Difficulty {
+    // Any difficulty, only used as a target.
+    Any,
+    // Solved by naked and hidden singles alone.
+    Easy,
+    // Also needs naked and hidden pairs, pointing, or box line reduction.
+    Medium,
+    // Needs guessing.
+    Hard
+};
+
+// BasicGenerator makes sudoku puzzles with N by N boxes that have exactly
+// one solution. A puzzle starts as a random solved grid, found by solving a
+// board with random boxes on the diagonal. Then its clues are removed one
+// at a time in random order, and a removal is undone if the puzzle no
+// longer has a unique solution. Removing stops at the target number of
+// clues, or once no clue can be removed.
+//
+// Since the puzzle had one solution before a clue was removed, it still
+// does if no solution has another value in the cell of the clue. That's
+// the search for a second solution of counting solutions up to 2, without
+// finding the first one again. The search is limited to a number of nodes,
+// and a clue stays if the search runs out, so puzzles with few clues, where
+// a single search can take minutes, stay quick to generate. Nodes aren't
+// time, so the same clues stay whatever the load on the machine.
+//
+// Every puzzle is generated from a seed and its number alone, so the same
+// seed gives the same puzzles however they're spread over threads. The
+// generator keeps solvers between puzzles, so use a copy per thread.
+template <int N>
+class BasicGenerator {
+public:
+    static constexpr int SIZE = BasicSudoku<N>::SIZE;
+    static constexpr int NUM_CELLS = BasicSudoku<N>::NUM_CELLS;
+
+private:
+    using Cells = std::array<std::uint8_t, NUM_CELLS>;
+
+    // Fills grids and counts solutions.
+    BasicSudokuBacktrack<N> solver;
+
+    // Rate puzzles with singles, and with every inference.
+    BasicSudokuBacktrack<N> singles;
+    BasicSudokuBacktrack<N> pairs;
+
+    int numClues = 0;
+    Difficulty difficulty = Difficulty::Any;
+    int maxAttempts = 1000;
+    long maxNodes = 4 * NUM_CELLS;
+
+    // Board of the puzzle being generated, reused between solver calls.
+    BasicSudoku<N> board;
+
+    // Stores a random solved grid in grid, row by row.
+    // effects: rng and grid change
+    void fill(std::mt19937_64 &rng, Cells &grid);
+
+    // Returns true if the puzzle in cells, which had exactly one solution
+    // with value at cell, still has exactly one solution without it, and
+    // false if it has another, or the search ran out of nodes.
+    // requires: cells[cell] == 0
+    bool isUnique(const Cells &cells, int cell, int value);
+
+    // Makes one attempt at a puzzle that meets the targets. Returns true and
+    // sets puzzle and solution if it does.
+    // effects: rng changes
+    //          puzzle and solution may change
+    bool attempt(std::mt19937_64 &rng, Cells &puzzle, Cells &solution);
+
+public:
+    BasicGenerator();
+
+    // Sets the number of clues to stop removing at, or 0 to remove as many
+    // as possible. Few clues take many attempts, ex. below 22 for 9x9
+    // sudoku.
+    inline void setNumClues(int n) {numClues = n;}
+
+    // Sets the difficulty that puzzles must have.
+    inline void setDifficulty(Difficulty d) {difficulty = d;}
+
+    // Sets the number of attempts before generate gives up on a puzzle.
+    inline void setMaxAttempts(int n) {maxAttempts = n;}
+
+    // Sets the number of nodes a search for a second solution may take
+    // before the clue it checks stays, or 0 for no limit.
+    inline void setMaxNodes(long n) {maxNodes = n;}
+
+    // Returns the difficulty of puzzle.
+    // requires: puzzle has exactly one solution
+    Difficulty rate(const BasicSudoku<N>& puzzle) const;
+
+    // Generates puzzle number index of the puzzles made from seed, and its
+    // solution, both row by row as in BasicSudoku::loadCells. Returns the
+    // number of attempts it took, or 0 if no attempt met the targets.
+    // requires: puzzle and solution have room for NUM_CELLS cells
+    int generate(std::uint64_t seed, std::uint64_t index, std::uint8_t *puzzle
+                 , std::uint8_t *solution);
+};
+
+// Generates 9x9 sudoku.
+using Generator = BasicGenerator<3>;
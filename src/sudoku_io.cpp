@@ -0,0 +1,139 @@
+#include "sudoku_io.h"
+#include <stdexcept>
+
+using namespace std;
+
+int symbolValue(char c) {
+    if (c == '.') return 0;
+    if ('0' <= c && c <= '9') return c - '0';
+    if ('A' <= c && c <= 'P') return c - 'A' + 10;
+    if ('a' <= c && c <= 'p') return c - 'a' + 10;
+    return -1;
+}
+
+char valueSymbol(int value) {
+    assert(0 <= value && value <= 25);
+    if (value < 10) return static_cast<char>('0' + value);
+    return static_cast<char>('A' + value - 10);
+}
+
+namespace {
+    inline bool isDigit(char c) {
+        return '0' <= c && c <= '9';
+    }
+}
+
+template <int N>
+BasicPuzzleReader<N>::BasicPuzzleReader(istream& in) : in(in), lineNumber(0) {}
+
+template <int N>
+int BasicPuzzleReader<N>::nextLine(array<int, NUM_CELLS> &cells) {
+    while (getline(in, line)) {
+        ++lineNumber;
+
+        int size = 0;
+        size_t i = 0;
+        while (i < line.size()) {
+            char c = line[i];
+            if (c == ' ' || c == '\t' || c == '\r') {
+                ++i;
+                continue;
+            }
+            if (c == '#' && size == 0) break;
+
+            // Find the end of the token starting at c
+            size_t end = line.find_first_of(" \t\r", i);
+            if (end == string::npos) end = line.size();
+
+            // A number of one or two digits is one cell, if values can have
+            // two digits
+            bool isNumber = SIZE > 9 && end - i <= 2 && isDigit(line[i])
+                            && isDigit(line[end-1]);
+
+            while (i < end) {
+                if (size >= NUM_CELLS) {
+                    throw runtime_error("Line " + to_string(lineNumber)
+                                        + " has too many cells");
+                }
+
+                int value;
+                if (isNumber) {
+                    value = stoi(line.substr(i, end - i));
+                    if (value > SIZE) {
+                        throw runtime_error("Line " + to_string(lineNumber)
+                                            + " has value " + to_string(value)
+                                            + " that is larger than "
+                                            + to_string(SIZE));
+                    }
+                    i = end;
+                } else {
+                    value = symbolValue(line[i]);
+                    if (value < 0 || value > SIZE) {
+                        throw runtime_error("Line " + to_string(lineNumber)
+                                            + " has character " + string(1, line[i])
+                                            + (SIZE <= 9 ? " that is not a digit"
+                                                         : " that is not a symbol"));
+                    }
+                    ++i;
+                }
+                cells[size++] = value;
+            }
+        }
+
+        // Skip blank lines and comments
+        if (size > 0) return size;
+    }
+    return -1;
+}
+
+template <int N>
+bool BasicPuzzleReader<N>::next(BasicSudoku<N>& board) {
+    array<int, NUM_CELLS> cells;
+
+    int size = nextLine(cells);
+    if (size == -1) return false;
+
+    // Single line puzzle
+    if (size == NUM_CELLS) {
+        for (int i=0; i<NUM_CELLS; ++i) {
+            board.initCell(i % SIZE, i / SIZE, cells[i]);
+        }
+        return true;
+    }
+
+    // Otherwise, a puzzle written as SIZE lines of SIZE cells
+    for (int y=0; y<SIZE; ++y) {
+        if (y > 0) size = nextLine(cells);
+
+        if (size == -1) {
+            throw runtime_error("Puzzle ends early with " + to_string(y)
+                                + " lines");
+        }
+        if (size != SIZE) {
+            throw runtime_error("Line " + to_string(lineNumber) + " has "
+                                + to_string(size) + " cells instead of "
+                                + to_string(SIZE) + " or " + to_string(NUM_CELLS));
+        }
+        for (int x=0; x<SIZE; ++x) {
+            board.initCell(x, y, cells[x]);
+        }
+    }
+    return true;
+}
+
+template <int N>
+void appendLine(string& str, const BasicSudoku<N>& board) {
+    for (int y=0; y<BasicSudoku<N>::SIZE; ++y) {
+        for (int x=0; x<BasicSudoku<N>::SIZE; ++x) {
+            str.push_back(valueSymbol(board.getCell(x, y)));
+        }
+    }
+}
+
+template class BasicPuzzleReader<3>;
+template class BasicPuzzleReader<4>;
+template class BasicPuzzleReader<5>;
+
+template void appendLine(string&, const BasicSudoku<3>&);
+template void appendLine(string&, const BasicSudoku<4>&);
+template void appendLine(string&, const BasicSudoku<5>&);
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <istream>
+#include <string>
+#include "sudoku.h"
+
+// Returns the value of the cell symbol c, 0 for an empty cell, or -1 if c
+// isn't a symbol. Values 1 to 9 are the digits, and values from 10 are the
+// letters, A or a for 10 up to P or p for 25. Empty cells are 0 or .
+int symbolValue(char c);
+
+// Returns the symbol of value, 0 for an empty cell, see symbolValue.
+// requires: 0 <= value <= 25
+char valueSymbol(int value);
+
+// BasicPuzzleSource is the interface of the readers that give sudoku
+// puzzles with N by N boxes one after another, so batch mode can solve
+// puzzles from any format.
+template <int N>
+class BasicPuzzleSource {
+public:
+    virtual ~BasicPuzzleSource() = default;
+
+    // Reads the next puzzle into board. Returns true if a puzzle was read,
+    // false if there are no more puzzles. Throws runtime_error if the
+    // puzzle is malformed. Reading can continue with the next puzzle after
+    // an error.
+    // requires: board is a newly constructed BasicSudoku
+    // effects: board may change
+    virtual bool next(BasicSudoku<N>& board) = 0;
+};
+
+// BasicPuzzleReader reads sudoku puzzles with N by N boxes one after
+// another from a stream. With SIZE = N*N, two formats are accepted, and can
+// be mixed in the same stream:
+// - A single line of SIZE*SIZE cells, like the common format used by puzzle
+//   collections. ex. 003020600900305001001806400008102900...
+// - SIZE lines of SIZE cells, like the files in examples/.
+// Cells are symbols, see symbolValue, with 0 or . for an empty cell.
+// Whitespace between cells is ignored. Blank lines and lines starting with #
+// are skipped.
+// Sudoku larger than 9x9 can also write values as numbers, separated by
+// whitespace. ex. 16 0 3 12 ... A whitespace separated token of one or two
+// digits is one cell, and every character of any other token is a cell.
+template <int N>
+class BasicPuzzleReader : public BasicPuzzleSource<N> {
+    static constexpr int SIZE = BasicSudoku<N>::SIZE;
+    static constexpr int NUM_CELLS = BasicSudoku<N>::NUM_CELLS;
+
+    std::istream& in;
+
+    // Buffer for the line being parsed, reused between reads.
+    std::string line;
+
+    // Number of lines read so far, for error messages.
+    int lineNumber;
+
+    // Reads the next line that isn't blank or a comment, and stores its
+    // cells in cells. Returns the number of cells on the line, or -1 at the
+    // end of the stream. Throws runtime_error if the line has a character
+    // that isn't a cell, or a value larger than SIZE.
+    // effects: cells may change
+    int nextLine(std::array<int, NUM_CELLS> &cells);
+
+public:
+    explicit BasicPuzzleReader(std::istream& in);
+
+    // Reads the next puzzle into board, as in BasicPuzzleSource::next.
+    // Returns false at the end of the stream.
+    // requires: board is a newly constructed BasicSudoku
+    // effects: board may change
+    bool next(BasicSudoku<N>& board) override;
+
+    // Returns the number of the last line read.
+    inline int getLineNumber() const {
+        return lineNumber;
+    }
+};
+
+// Reads 9x9 sudoku.
+using PuzzleReader = BasicPuzzleReader<3>;
+
+// Appends the board to str as a single line of SIZE*SIZE symbols, see
+// symbolValue, with 0 for empty cells. 9x9 sudoku are written as digits.
+// Does not append a newline.
+template <int N>
+void appendLine(std::string& str, const BasicSudoku<N>& board);
@@ -0,0 +1,130 @@
+#include "sudoku_lockstep.h"
+using namespace std;
+
+namespace {
+    // Returns all ones if mask has exactly one value, zero otherwise.
+    // Branch free, so the loops over lanes vectorize.
+    template <typename Mask>
+    inline Mask singleLane(Mask mask) {
+        bool single = ((mask & (mask - 1)) == 0) & (mask != 0);
+        return static_cast<Mask>(-static_cast<Mask>(single));
+    }
+}
+
+template <int N>
+uint32_t BasicLockstepSolver<N>::propagate() {
+    using Tables = typename Board::Tables;
+    using Lanes = array<Mask, LANES>;
+
+    // Lanes that broke the rules, and lanes with cells left to fill, as
+    // all ones or zero
+    Lanes failed{};
+    Lanes unfilled{};
+    bool changed = true;
+
+    while (changed) {
+        changed = false;
+        unfilled.fill(0);
+
+        for (const auto &unit : Tables::UNITS) {
+            // Values of the filled cells, the values filled twice, every
+            // possible value, and the values possible in two cells or more
+            Lanes filled{};
+            Lanes filledTwice{};
+            Lanes possible{};
+            Lanes possibleTwice{};
+            for (int cell : unit) {
+                const Mask *m = &masks[cell*LANES];
+                for (int i=0; i<LANES; ++i) {
+                    Mask single = singleLane(m[i]);
+                    Mask value = m[i] & single;
+                    filledTwice[i] |= filled[i] & value;
+                    filled[i] |= value;
+                    possibleTwice[i] |= possible[i] & m[i];
+                    possible[i] |= m[i];
+                    unfilled[i] |= static_cast<Mask>(~single);
+                }
+            }
+
+            // The unit breaks the rules if a value is filled twice, or has
+            // no cell left
+            Lanes once;
+            for (int i=0; i<LANES; ++i) {
+                bool valid = (filledTwice[i] == 0) & (possible[i] == Board::ALL_VALUES);
+                failed[i] |= static_cast<Mask>(static_cast<Mask>(valid) - 1);
+                once[i] = possible[i] & static_cast<Mask>(~possibleTwice[i]);
+            }
+
+            // Remove the filled values from the other cells, and keep only
+            // the value of a hidden single, a value possible in one cell
+            Mask diff = 0;
+            for (int cell : unit) {
+                Mask *m = &masks[cell*LANES];
+                for (int i=0; i<LANES; ++i) {
+                    Mask single = singleLane(m[i]);
+                    Mask left = m[i] & static_cast<Mask>(~filled[i]);
+                    Mask hidden = left & once[i];
+                    left = hidden != 0 ? hidden : left;
+                    left = static_cast<Mask>((m[i] & single) | (left & ~single));
+                    diff |= left ^ m[i];
+                    m[i] = left;
+                }
+            }
+            if (diff != 0) changed = true;
+        }
+    }
+
+    uint32_t solved = 0;
+    for (int i=0; i<LANES; ++i) {
+        if ((failed[i] | unfilled[i]) == 0) solved |= 1u << i;
+    }
+    return solved;
+}
+
+template <int N>
+uint32_t BasicLockstepSolver<N>::solve(Board *const *boards, int count) {
+    assert(count >= 0 && count <= LANES);
+    if (count == 0) return 0;
+
+    // Lanes without a board have every value possible in every cell, so
+    // they're never solved
+    for (int cell=0; cell<NUM_CELLS; ++cell) {
+        Mask *m = &masks[cell*LANES];
+        for (int i=0; i<LANES; ++i) {
+            if (i >= count) {
+                m[i] = Board::ALL_VALUES;
+            } else if (boards[i]->isEmpty(cell)) {
+                m[i] = boards[i]->getValues(cell);
+            } else {
+                m[i] = valueBit<Mask>(boards[i]->getCell(cell));
+            }
+        }
+    }
+
+    uint32_t solved = 0;
+    bool vectorized = false;
+#if SUDOKU_SIMD
+    if constexpr (sizeof(Mask) == 2) {
+        if (simd::enabled()) {
+            solved = simd::propagateSingles(masks.data(), &Board::Tables::UNITS[0][0]
+                                            , Board::Tables::NUM_UNITS, SIZE
+                                            , Board::ALL_VALUES);
+            vectorized = true;
+        }
+    }
+#endif
+    if (!vectorized) solved = propagate();
+    solved &= (1u << count) - 1;
+
+    for (int i=0; i<count; ++i) {
+        if ((solved >> i & 1) == 0) continue;
+        for (int cell=0; cell<NUM_CELLS; ++cell) {
+            if (boards[i]->isEmpty(cell)) boards[i]->setCell(cell, lowestValue(masks[cell*LANES + i]));
+        }
+    }
+    return solved;
+}
+
+template class BasicLockstepSolver<3>;
+template class BasicLockstepSolver<4>;
+template class BasicLockstepSolver<5>;
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "sudoku.h"
+
+// BasicLockstepSolver solves several easy sudoku puzzles with N by N boxes
+// at once, by filling in naked and hidden singles until none are left. Most
+// easy puzzles are solved by singles alone, and solving them one board at
+// a time spends more time setting up each search than searching.
+//
+// The puzzles are laid out side by side: for every cell, the possible
+// values of the cell in every puzzle, one lane per puzzle. So one pass over
+// the units of the board works on every puzzle, and a 256 bit vector holds
+// one cell of 16 puzzles with 16 bit masks, 9x9 and 16x16 sudoku, or 8
+// puzzles with 32 bit masks. The passes are vectorized with AVX2 for 16 bit
+// masks, see simd::propagateSingles, and use scalar loops otherwise.
+//
+// Singles are forced, so a puzzle filled by them has exactly one solution.
+// Puzzles that need a guess, or that break the rules, are left for another
+// solver.
+template <int N>
+class BasicLockstepSolver {
+public:
+    using Board = BasicSudoku<N>;
+    using Mask = typename Board::Mask;
+    static constexpr int SIZE = Board::SIZE;
+    static constexpr int NUM_CELLS = Board::NUM_CELLS;
+
+    // Number of puzzles solved at once, as many masks as fit in 256 bits.
+    static constexpr int LANES = 32 / sizeof(Mask);
+
+private:
+    // Possible values of every cell in every puzzle, lane i of cell c at
+    // masks[c*LANES + i].
+    alignas(32) std::array<Mask, NUM_CELLS * LANES> masks;
+
+    // Scalar loops of simd::propagateSingles. Returns one bit per lane set
+    // if its puzzle was filled without breaking the rules.
+    std::uint32_t propagate();
+
+public:
+    // Fills in the singles of boards[0] to boards[count - 1], and writes the
+    // solutions of the puzzles solved to their boards. Returns one bit per
+    // board, bit i set if boards[i] was solved. The other boards are
+    // unchanged.
+    // requires: 0 <= count <= LANES
+    // effects: boards may change
+    std::uint32_t solve(Board *const *boards, int count);
+};
+
+// Solves up to 16 easy 9x9 puzzles at once.
+using LockstepSolver = BasicLockstepSolver<3>;
@@ -0,0 +1,168 @@
+#include "sudoku_portfolio.h"
+#include <cassert>
+#include <condition_variable>
+#include "sudoku_backtrack.h"
+#include "sudoku_dlx.h"
+using namespace std;
+
+template <int N>
+struct BasicPortfolioSolver<N>::Race {
+    // Cancelled once a solver answers, or once the caller's token is.
+    CancelToken cancel;
+
+    // Guards everything below. Signalled when numRunning reaches 0.
+    std::mutex mutex;
+    condition_variable finished;
+
+    // Number of solvers still searching.
+    int numRunning = 0;
+
+    // First solver to answer, its answer, and its solution.
+    int winner = -1;
+    SolveResult result = SolveResult::TimedOut;
+    BasicSudoku<N> solution;
+
+    explicit Race(const CancelToken *parent) : cancel(parent) {}
+};
+
+template <int N>
+BasicPortfolioSolver<N>::BasicPortfolioSolver() : wins(make_shared<Wins>()) {}
+
+template <int N>
+void BasicPortfolioSolver<N>::addSolver(const string &name
+                                        , unique_ptr<BasicSudokuSolver<N>> solver) {
+    assert(!pool);
+    members.push_back(Member{name, move(solver)});
+
+    lock_guard<std::mutex> lock(wins->mutex);
+    wins->counts.resize(members.size());
+}
+
+template <int N>
+bool BasicPortfolioSolver<N>::solve(BasicSudoku<N>& board) {
+    return solveWithin(board, SearchLimits()) == SolveResult::Solved;
+}
+
+template <int N>
+SolveResult BasicPortfolioSolver<N>::solveWithin(BasicSudoku<N>& board
+                                                , const SearchLimits &limits) {
+    assert(!members.empty());
+    int numMembers = static_cast<int>(members.size());
+    if (numMembers > 1 && !pool) pool = make_unique<ThreadPool>(numMembers - 1);
+
+    Race race(limits.cancel);
+    race.numRunning = numMembers;
+
+    SearchLimits raceLimits = limits;
+    raceLimits.cancel = &race.cancel;
+
+    // Every solver searches its own copy of the board
+    for (int i=1; i<numMembers; ++i) {
+        pool->submit([this, i, board, &raceLimits, &race]() mutable {
+            run(i, board, raceLimits, race);
+        });
+    }
+    BasicSudoku<N> copy = board;
+    run(0, copy, raceLimits, race);
+
+    // Wait for the other solvers, which stop soon after the first answer,
+    // since they reference race
+    unique_lock<std::mutex> lock(race.mutex);
+    race.finished.wait(lock, [&race] {return race.numRunning == 0;});
+
+    lastWinner = race.winner;
+    if (race.winner < 0) {
+        bool cancelled = limits.cancel != nullptr && limits.cancel->isCancelled();
+        return cancelled ? SolveResult::Cancelled : SolveResult::TimedOut;
+    }
+
+    if (race.result == SolveResult::Solved) board = race.solution;
+    {
+        lock_guard<std::mutex> winsLock(wins->mutex);
+        ++wins->counts[race.winner];
+    }
+    return race.result;
+}
+
+template <int N>
+void BasicPortfolioSolver<N>::run(int index, BasicSudoku<N>& board
+                                  , const SearchLimits &limits, Race &race) {
+    SolveResult result = members[index].solver->solveWithin(board, limits);
+
+    // Notify while holding the lock, since race is gone once the last
+    // solver finishes.
+    lock_guard<std::mutex> lock(race.mutex);
+    bool answered = result == SolveResult::Solved || result == SolveResult::Unsolvable;
+    if (answered && race.winner < 0) {
+        race.winner = index;
+        race.result = result;
+        if (result == SolveResult::Solved) race.solution = board;
+        race.cancel.cancel();
+    }
+    if (--race.numRunning == 0) race.finished.notify_all();
+}
+
+template <int N>
+int BasicPortfolioSolver<N>::countSolutions(BasicSudoku<N>& board, int limit) {
+    assert(!members.empty());
+    lastWinner = 0;
+    return members[0].solver->countSolutions(board, limit);
+}
+
+template <int N>
+CountResult BasicPortfolioSolver<N>::countWithin(BasicSudoku<N>& board, int limit
+                                                 , const SearchLimits &limits) {
+    assert(!members.empty());
+    lastWinner = 0;
+    return members[0].solver->countWithin(board, limit, limits);
+}
+
+template <int N>
+unique_ptr<BasicSudokuSolver<N>> BasicPortfolioSolver<N>::clone() const {
+    auto portfolio = make_unique<BasicPortfolioSolver>();
+    for (const Member &member : members) {
+        portfolio->members.push_back(Member{member.name, member.solver->clone()});
+    }
+    portfolio->wins = wins;
+    return portfolio;
+}
+
+template <int N>
+SearchStats BasicPortfolioSolver<N>::getStats() const {
+    if (lastWinner < 0) return SearchStats();
+    return members[lastWinner].solver->getStats();
+}
+
+template <int N>
+long BasicPortfolioSolver<N>::getNumWins(int index) const {
+    lock_guard<std::mutex> lock(wins->mutex);
+    return wins->counts[index];
+}
+
+template <int N>
+unique_ptr<BasicPortfolioSolver<N>> makeDefaultPortfolio() {
+    auto portfolio = make_unique<BasicPortfolioSolver<N>>();
+
+    auto addBacktrack = [&](const string &name, int heuristic, int inference) {
+        auto backtrack = make_unique<BasicSudokuBacktrack<N>>();
+        backtrack->setHeuristic(heuristic);
+        backtrack->setInference(inference);
+        portfolio->addSolver(name, move(backtrack));
+    };
+    // Dancing links only solves 9x9 sudoku, so larger sudoku race
+    // forward checking without value ordering instead
+    if constexpr (N != 3) addBacktrack("h2-i1", 2, 1);
+    addBacktrack("h3-i1", 3, 1);
+    addBacktrack("h3-i2", 3, 2);
+    if constexpr (N == 3) portfolio->addSolver("dlx", make_unique<SudokuDLX>());
+
+    return portfolio;
+}
+
+template class BasicPortfolioSolver<3>;
+template class BasicPortfolioSolver<4>;
+template class BasicPortfolioSolver<5>;
+
+template unique_ptr<BasicPortfolioSolver<3>> makeDefaultPortfolio();
+template unique_ptr<BasicPortfolioSolver<4>> makeDefaultPortfolio();
+template unique_ptr<BasicPortfolioSolver<5>> makeDefaultPortfolio();
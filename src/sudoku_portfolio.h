@@ -0,0 +1,120 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "sudoku_solver.h"
+#include "thread_pool.h"
+
+// BasicPortfolioSolver races several solvers for sudoku puzzles with N by N
+// boxes, ex. backtracking with different heuristics and dancing links. No
+// single configuration is fastest on every puzzle, so every solver searches
+// its own copy of the board on its own thread, and the first to finish
+// answers. The others are cancelled, see CancelToken, so they stop within
+// a few microseconds.
+//
+// The portfolio counts how often each solver won, so the configurations
+// that never win can be dropped. Clones share the counts.
+//
+// The first solver runs on the calling thread, and the others on threads
+// owned by the portfolio, so every clone uses one thread per solver.
+template <int N>
+class BasicPortfolioSolver : public BasicSudokuSolver<N> {
+    struct Member {
+        std::string name;
+        std::unique_ptr<BasicSudokuSolver<N>> solver;
+    };
+
+    // Wins of each solver, shared by clones.
+    struct Wins {
+        std::mutex mutex;
+        std::vector<long> counts;
+    };
+
+    // Shared state of one race.
+    struct Race;
+
+    std::vector<Member> members;
+    std::shared_ptr<Wins> wins;
+
+    // Runs every solver but the first, created on the first race.
+    std::unique_ptr<ThreadPool> pool;
+
+    // Index of the solver that answered the last puzzle, or -1.
+    int lastWinner = -1;
+
+    // Solves board with solver index within limits, and records the result
+    // in race if it's the first to finish.
+    // effects: board may change
+    //          race may change
+    void run(int index, BasicSudoku<N>& board, const SearchLimits &limits
+             , Race &race);
+
+public:
+    BasicPortfolioSolver();
+
+    // Adds solver to the portfolio, named name in the win counts. Solvers
+    // added first win ties.
+    // requires: the portfolio hasn't solved a puzzle yet
+    void addSolver(const std::string &name
+                   , std::unique_ptr<BasicSudokuSolver<N>> solver);
+
+    // Solves board with every solver at once, and returns the first
+    // answer.
+    // requires: the portfolio has >= 1 solver
+    // effects: board may change
+    bool solve(BasicSudoku<N>& board) override;
+
+    // Same as solve, but every solver gives up once limits are reached, see
+    // BasicSudokuSolver::solveWithin. The node limit applies to each
+    // solver on its own.
+    // requires: the portfolio has >= 1 solver
+    // effects: board may change
+    SolveResult solveWithin(BasicSudoku<N>& board, const SearchLimits &limits) override;
+
+    // Counts solutions with the first solver only, since every solver finds
+    // the same count.
+    // requires: the portfolio has >= 1 solver
+    // effects: board may change
+    int countSolutions(BasicSudoku<N>& board, int limit) override;
+
+    // Same as countSolutions, but gives up once limits are reached, see
+    // BasicSudokuSolver::countWithin.
+    // requires: the portfolio has >= 1 solver
+    // effects: board may change
+    CountResult countWithin(BasicSudoku<N>& board, int limit
+                            , const SearchLimits &limits) override;
+
+    std::unique_ptr<BasicSudokuSolver<N>> clone() const override;
+
+    // Returns the stats of the solver that answered the last puzzle.
+    SearchStats getStats() const override;
+
+    inline int getNumSolvers() const {
+        return static_cast<int>(members.size());
+    }
+
+    inline const std::string& getName(int index) const {
+        return members[index].name;
+    }
+
+    // Returns the number of puzzles solver index answered first, over this
+    // portfolio and its clones.
+    long getNumWins(int index) const;
+
+    // Returns the index of the solver that answered the last puzzle, or -1
+    // if every solver gave up.
+    inline int getLastWinner() const {
+        return lastWinner;
+    }
+};
+
+// Returns a portfolio of backtracking with singles, backtracking with every
+// inference, and dancing links for 9x9 sudoku, or backtracking without
+// value ordering for larger sudoku.
+template <int N>
+std::unique_ptr<BasicPortfolioSolver<N>> makeDefaultPortfolio();
+
+// Portfolio of engines for 9x9 sudoku.
+using PortfolioSolver = BasicPortfolioSolver<3>;
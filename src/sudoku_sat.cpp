@@ -0,0 +1,546 @@
+#include "sudoku_sat.h"
+#include <algorithm>
+#include <cstring>
+using namespace std;
+
+namespace {
+    // Activities decay by these factors after every conflict.
+    constexpr double VAR_DECAY = 0.95;
+    constexpr float CLAUSE_DECAY = 0.999f;
+
+    // Conflicts before the first restart, multiplied by the Luby sequence.
+    constexpr int RESTART_BASE = 100;
+
+    // Learned clauses kept before the first reduction, and the growth of
+    // that limit after every reduction.
+    constexpr int MIN_LEARNTS = 2000;
+    constexpr double LEARNTS_GROWTH = 1.1;
+
+    // Returns element i of the Luby sequence 1, 1, 2, 1, 1, 2, 4, 1, ...
+    long luby(int i) {
+        // Find the finite subsequence that contains index i, and its size
+        int size = 1;
+        int seq = 0;
+        while (size < i+1) {
+            ++seq;
+            size = 2*size + 1;
+        }
+        while (size-1 != i) {
+            size = (size-1) >> 1;
+            --seq;
+            i = i % size;
+        }
+        return 1l << seq;
+    }
+}
+
+template <int N>
+BasicSudokuSAT<N>::BasicSudokuSAT()
+    : watches(2 * NUM_VARS), values(NUM_VARS, UNASSIGNED), levels(NUM_VARS)
+    , reasons(NUM_VARS, NO_REASON), phases(NUM_VARS, TRUE), activities(NUM_VARS)
+    , heapIndex(NUM_VARS, -1), seen(NUM_VARS) {
+
+    // Every cell has a value
+    vector<int> literals(SIZE);
+    for (int cell=0; cell<NUM_CELLS; ++cell) {
+        for (int d=0; d<SIZE; ++d) literals[d] = 2 * (cell*SIZE + d);
+        addClause(literals, false);
+    }
+
+    // Every unit has every value
+    for (const auto &unit : Board::Tables::UNITS) {
+        for (int d=0; d<SIZE; ++d) {
+            for (int i=0; i<SIZE; ++i) literals[i] = 2 * (unit[i]*SIZE + d);
+            addClause(literals, false);
+        }
+    }
+
+    rulesSize = static_cast<int>(arena.size());
+    trail.reserve(NUM_VARS);
+}
+
+template <int N>
+float BasicSudokuSAT<N>::getActivity(int c) const {
+    float activity;
+    memcpy(&activity, &arena[c + 1], sizeof(activity));
+    return activity;
+}
+
+template <int N>
+void BasicSudokuSAT<N>::setActivity(int c, float activity) {
+    memcpy(&arena[c + 1], &activity, sizeof(activity));
+}
+
+template <int N>
+int BasicSudokuSAT<N>::addClause(const vector<int> &literals, bool learnt) {
+    int c = static_cast<int>(arena.size());
+    arena.push_back(static_cast<uint32_t>(literals.size()) << 2 | (learnt ? 1u : 0u));
+    if (learnt) arena.push_back(0);
+    for (int literal : literals) arena.push_back(static_cast<uint32_t>(literal));
+    if (learnt) setActivity(c, 0);
+
+    watch(c);
+    return c;
+}
+
+template <int N>
+void BasicSudokuSAT<N>::assign(int literal, int reason) {
+    int variable = literal >> 1;
+    values[variable] = (literal & 1) ? FALSE : TRUE;
+    levels[variable] = decisionLevel();
+    reasons[variable] = reason;
+    trail.push_back(literal);
+}
+
+template <int N>
+bool BasicSudokuSAT<N>::propagate() {
+    while (head < static_cast<int>(trail.size())) {
+        const int p = trail[head++];
+
+        // A value of a cell rules out the other values of the cell, and the
+        // value in its peers.
+        if ((p & 1) == 0) {
+            const int cell = (p >> 1) / SIZE;
+            const int d = (p >> 1) % SIZE;
+
+            auto ruleOut = [&](int variable) {
+                int q = 2 * variable;
+                if (values[variable] == UNASSIGNED) {
+                    assign(q ^ 1, -2 - p);
+                    if constexpr (STATS_ENABLED) ++stats.valuesPropagated;
+                    return true;
+                }
+                if (values[variable] == FALSE) return true;
+
+                conflict.assign({p ^ 1, q ^ 1});
+                conflictClause = NO_REASON;
+                return false;
+            };
+
+            for (int e=0; e<SIZE; ++e) {
+                if (e != d && !ruleOut(cell*SIZE + e)) return false;
+            }
+            for (CellIndex peer : Board::Tables::PEERS[cell]) {
+                if (!ruleOut(peer*SIZE + d)) return false;
+            }
+        }
+
+        // Visit the clauses watching the literal that became false. Clauses
+        // that find another literal to watch move to its list, the rest
+        // stay, compacted to the front.
+        const int falseLiteral = p ^ 1;
+        vector<Watch> &list = watches[falseLiteral];
+        size_t i = 0;
+        size_t j = 0;
+        while (i < list.size()) {
+            Watch w = list[i++];
+            if (valueOf(w.blocker) == TRUE) {
+                list[j++] = w;
+                continue;
+            }
+
+            // Keep the false literal second
+            uint32_t *literals = clauseLiterals(w.clause);
+            if (static_cast<int>(literals[0]) == falseLiteral) swap(literals[0], literals[1]);
+            const int first = static_cast<int>(literals[0]);
+            w.blocker = first;
+            if (valueOf(first) == TRUE) {
+                list[j++] = w;
+                continue;
+            }
+
+            const int size = clauseSize(w.clause);
+            bool moved = false;
+            for (int k=2; k<size; ++k) {
+                if (valueOf(static_cast<int>(literals[k])) != FALSE) {
+                    swap(literals[1], literals[k]);
+                    watches[literals[1]].push_back(w);
+                    moved = true;
+                    break;
+                }
+            }
+            if (moved) continue;
+
+            // Every other literal is false, so the clause implies the first,
+            // or fails if it's false too.
+            list[j++] = w;
+            if (valueOf(first) == FALSE) {
+                while (i < list.size()) list[j++] = list[i++];
+                list.resize(j);
+                conflict.assign(literals, literals + size);
+                conflictClause = w.clause;
+                return false;
+            }
+            assign(first, w.clause);
+            if constexpr (STATS_ENABLED) ++stats.valuesPropagated;
+        }
+        list.resize(j);
+    }
+
+    return true;
+}
+
+template <int N>
+template <typename Visit>
+void BasicSudokuSAT<N>::reasonOf(int variable, Visit visit) const {
+    const int reason = reasons[variable];
+    if (reason >= 0) {
+        // The implied literal is first
+        const uint32_t *literals = clauseLiterals(reason);
+        for (int k=1; k<clauseSize(reason); ++k) visit(static_cast<int>(literals[k]));
+    } else if (reason <= -2) {
+        visit((-2 - reason) ^ 1);
+    }
+}
+
+template <int N>
+int BasicSudokuSAT<N>::analyze() {
+    learnt.clear();
+    learnt.push_back(-1);
+
+    // Literals of the current level still to resolve
+    int pathCount = 0;
+    auto visit = [&](int q) {
+        int variable = q >> 1;
+        if (seen[variable] || levels[variable] == 0) return;
+
+        seen[variable] = 1;
+        bumpVariable(variable);
+        if (levels[variable] >= decisionLevel()) {
+            ++pathCount;
+        } else {
+            learnt.push_back(q);
+        }
+    };
+
+    if (conflictClause >= 0 && isLearnt(conflictClause)) bumpClause(conflictClause);
+    for (int q : conflict) visit(q);
+
+    // Resolve with the reasons of the literals of the current level, latest
+    // first, until one is left, the first unique implication point.
+    int index = static_cast<int>(trail.size()) - 1;
+    int p;
+    while (true) {
+        while (!seen[trail[index] >> 1]) --index;
+        p = trail[index--];
+        seen[p >> 1] = 0;
+        if (--pathCount == 0) break;
+
+        int reason = reasons[p >> 1];
+        if (reason >= 0 && isLearnt(reason)) bumpClause(reason);
+        reasonOf(p >> 1, visit);
+    }
+    learnt[0] = p ^ 1;
+
+    // Drop literals implied by the other literals of the clause
+    size_t j = 1;
+    for (size_t i=1; i<learnt.size(); ++i) {
+        int variable = learnt[i] >> 1;
+        bool implied = reasons[variable] != NO_REASON;
+        reasonOf(variable, [&](int q) {
+            if (!seen[q >> 1] && levels[q >> 1] > 0) implied = false;
+        });
+        if (implied) {
+            seen[variable] = 0;
+        } else {
+            learnt[j++] = learnt[i];
+        }
+    }
+    learnt.resize(j);
+    for (size_t i=1; i<learnt.size(); ++i) seen[learnt[i] >> 1] = 0;
+
+    // Go back to the latest level of the other literals, watched second
+    if (learnt.size() == 1) return 0;
+    size_t latest = 1;
+    for (size_t i=2; i<learnt.size(); ++i) {
+        if (levels[learnt[i] >> 1] > levels[learnt[latest] >> 1]) latest = i;
+    }
+    swap(learnt[1], learnt[latest]);
+    return levels[learnt[1] >> 1];
+}
+
+template <int N>
+void BasicSudokuSAT<N>::backtrack(int level) {
+    if (decisionLevel() <= level) return;
+
+    const int start = trailLimits[level];
+    for (int i = static_cast<int>(trail.size())-1; i >= start; --i) {
+        int variable = trail[i] >> 1;
+        phases[variable] = values[variable];
+        values[variable] = UNASSIGNED;
+        if (heapIndex[variable] < 0) heapInsert(variable);
+    }
+    trail.resize(start);
+    trailLimits.resize(level);
+    head = start;
+}
+
+template <int N>
+void BasicSudokuSAT<N>::reduceLearnts() {
+    // A clause is locked while it's the reason of its first literal
+    auto isLocked = [&](int c) {
+        int first = static_cast<int>(clauseLiterals(c)[0]);
+        return valueOf(first) == TRUE && reasons[first >> 1] == c;
+    };
+
+    vector<int> sorted = learnts;
+    sort(sorted.begin(), sorted.end(), [&](int a, int b) {
+        return getActivity(a) < getActivity(b);
+    });
+    for (size_t i=0; i<sorted.size()/2; ++i) {
+        int c = sorted[i];
+        if (clauseSize(c) > 2 && !isLocked(c)) arena[c] |= 2;
+    }
+
+    // Move the clauses kept to the front, in order, and remember where each
+    // clause went.
+    vector<pair<int, int>> moves;
+    learnts.clear();
+    int size = rulesSize;
+    for (int c = rulesSize; c < static_cast<int>(arena.size()); ) {
+        int end = clauseEnd(c);
+        if (!isRemoved(c)) {
+            moves.emplace_back(c, size);
+            if (isLearnt(c)) learnts.push_back(size);
+            copy(arena.begin() + c, arena.begin() + end, arena.begin() + size);
+            size += end - c;
+        }
+        c = end;
+    }
+    arena.resize(size);
+
+    for (int literal : trail) {
+        int &reason = reasons[literal >> 1];
+        if (reason < rulesSize) continue;
+        reason = lower_bound(moves.begin(), moves.end(), make_pair(reason, 0))->second;
+    }
+
+    for (auto &list : watches) list.clear();
+    for (int c=0; c<size; c = clauseEnd(c)) watch(c);
+}
+
+template <int N>
+void BasicSudokuSAT<N>::bumpVariable(int variable) {
+    if ((activities[variable] += varIncrement) > 1e100) {
+        for (double &activity : activities) activity *= 1e-100;
+        varIncrement *= 1e-100;
+    }
+    if (heapIndex[variable] >= 0) heapUp(heapIndex[variable]);
+}
+
+template <int N>
+void BasicSudokuSAT<N>::bumpClause(int c) {
+    float activity = getActivity(c) + clauseIncrement;
+    setActivity(c, activity);
+    if (activity > 1e20f) {
+        for (int learnt : learnts) setActivity(learnt, getActivity(learnt) * 1e-20f);
+        clauseIncrement *= 1e-20f;
+    }
+}
+
+template <int N>
+void BasicSudokuSAT<N>::heapUp(int i) {
+    const int variable = heap[i];
+    while (i > 0) {
+        int parent = (i-1) / 2;
+        if (activities[heap[parent]] >= activities[variable]) break;
+        heap[i] = heap[parent];
+        heapIndex[heap[i]] = i;
+        i = parent;
+    }
+    heap[i] = variable;
+    heapIndex[variable] = i;
+}
+
+template <int N>
+void BasicSudokuSAT<N>::heapDown(int i) {
+    const int variable = heap[i];
+    const int size = static_cast<int>(heap.size());
+    while (2*i + 1 < size) {
+        int child = 2*i + 1;
+        if (child+1 < size && activities[heap[child+1]] > activities[heap[child]]) ++child;
+        if (activities[heap[child]] <= activities[variable]) break;
+        heap[i] = heap[child];
+        heapIndex[heap[i]] = i;
+        i = child;
+    }
+    heap[i] = variable;
+    heapIndex[variable] = i;
+}
+
+template <int N>
+void BasicSudokuSAT<N>::heapInsert(int variable) {
+    heap.push_back(variable);
+    heapUp(static_cast<int>(heap.size()) - 1);
+}
+
+template <int N>
+int BasicSudokuSAT<N>::heapPop() {
+    const int top = heap[0];
+    heapIndex[top] = -1;
+    const int last = heap.back();
+    heap.pop_back();
+    if (!heap.empty()) {
+        heap[0] = last;
+        heapIndex[last] = 0;
+        heapDown(0);
+    }
+    return top;
+}
+
+template <int N>
+int BasicSudokuSAT<N>::pickBranch() {
+    while (!heap.empty()) {
+        int variable = heapPop();
+        if (values[variable] == UNASSIGNED) {
+            return 2*variable + (phases[variable] == TRUE ? 0 : 1);
+        }
+    }
+    return -1;
+}
+
+template <int N>
+bool BasicSudokuSAT<N>::reset(const Board& board) {
+    arena.resize(rulesSize);
+    learnts.clear();
+    for (auto &list : watches) list.clear();
+    for (int c=0; c<rulesSize; c = clauseEnd(c)) watch(c);
+
+    fill(values.begin(), values.end(), UNASSIGNED);
+    fill(phases.begin(), phases.end(), TRUE);
+    fill(activities.begin(), activities.end(), 0.0);
+    heap.resize(NUM_VARS);
+    for (int variable=0; variable<NUM_VARS; ++variable) {
+        heap[variable] = variable;
+        heapIndex[variable] = variable;
+    }
+    varIncrement = 1;
+    clauseIncrement = 1;
+    maxLearnts = MIN_LEARNTS;
+
+    trail.clear();
+    trailLimits.clear();
+    head = 0;
+
+    for (int cell=0; cell<NUM_CELLS; ++cell) {
+        int value = board.getCell(cell);
+        if (value != 0) assign(2 * (cell*SIZE + value-1), NO_REASON);
+    }
+    return propagate();
+}
+
+template <int N>
+int BasicSudokuSAT<N>::run(Board& board, int limit, SearchBudget &budget) {
+    stats = SearchStats();
+    if (!reset(board)) return 0;
+
+    int count = 0;
+    int restarts = 0;
+    long conflicts = 0;
+    long restartLimit = RESTART_BASE * luby(0);
+
+    while (true) {
+        if (!propagate()) {
+            if constexpr (STATS_ENABLED) ++stats.backtracks;
+            if (decisionLevel() == 0) return count;
+
+            int level = analyze();
+            backtrack(level);
+            if (learnt.size() == 1) {
+                assign(learnt[0], NO_REASON);
+            } else {
+                int c = addClause(learnt, true);
+                learnts.push_back(c);
+                bumpClause(c);
+                assign(learnt[0], c);
+            }
+            varIncrement /= VAR_DECAY;
+            clauseIncrement /= CLAUSE_DECAY;
+            ++conflicts;
+            continue;
+        }
+
+        if (conflicts >= restartLimit) {
+            backtrack(0);
+            conflicts = 0;
+            restartLimit = RESTART_BASE * luby(++restarts);
+        }
+        if (static_cast<int>(learnts.size()) >= maxLearnts) {
+            reduceLearnts();
+            maxLearnts = static_cast<int>(maxLearnts * LEARNTS_GROWTH);
+        }
+
+        int literal = pickBranch();
+        if (literal < 0) {
+            // Every variable is assigned, so every cell has one value
+            for (int cell=0; cell<NUM_CELLS; ++cell) {
+                for (int d=0; d<SIZE; ++d) {
+                    if (values[cell*SIZE + d] == TRUE) board.setCell(cell, d+1);
+                }
+            }
+            if (++count == limit) return count;
+
+            // Rule out the solution with a clause of the negated decisions,
+            // which implies the negation of the last decision one level up.
+            int numDecisions = decisionLevel();
+            if (numDecisions == 0) return count;
+            learnt.clear();
+            for (int level = numDecisions-1; level >= 0; --level) {
+                learnt.push_back(trail[trailLimits[level]] ^ 1);
+            }
+            backtrack(numDecisions - 1);
+            if (learnt.size() == 1) {
+                assign(learnt[0], NO_REASON);
+            } else {
+                assign(learnt[0], addClause(learnt, false));
+            }
+            continue;
+        }
+
+        if (budget.spend()) return count;
+        if constexpr (STATS_ENABLED) {
+            ++stats.nodes;
+            stats.maxDepth = max(stats.maxDepth, decisionLevel() + 1);
+        }
+        trailLimits.push_back(static_cast<int>(trail.size()));
+        assign(literal, NO_REASON);
+    }
+}
+
+template <int N>
+bool BasicSudokuSAT<N>::solve(Board& board) {
+    SearchBudget unlimited;
+    return run(board, 1, unlimited) == 1;
+}
+
+template <int N>
+SolveResult BasicSudokuSAT<N>::solveWithin(Board& board, const SearchLimits &limits) {
+    SearchBudget limited(&limits);
+    if (run(board, 1, limited) == 1) return SolveResult::Solved;
+    return limited.isStopped() ? limited.getReason() : SolveResult::Unsolvable;
+}
+
+template <int N>
+int BasicSudokuSAT<N>::countSolutions(Board& board, int limit) {
+    if (limit <= 0) return 0;
+    SearchBudget unlimited;
+    return run(board, limit, unlimited);
+}
+
+template <int N>
+CountResult BasicSudokuSAT<N>::countWithin(Board& board, int limit
+                                           , const SearchLimits &limits) {
+    if (limit <= 0) return CountResult();
+    SearchBudget limited(&limits);
+    int count = run(board, limit, limited);
+    return makeCountResult(count, limit, limited);
+}
+
+template <int N>
+unique_ptr<BasicSudokuSolver<N>> BasicSudokuSAT<N>::clone() const {
+    return make_unique<BasicSudokuSAT<N>>();
+}
+
+template class BasicSudokuSAT<3>;
+template class BasicSudokuSAT<4>;
+template class BasicSudokuSAT<5>;
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "sudoku.h"
+#include "sudoku_solver.h"
+
+// BasicSudokuSAT solves sudoku puzzles with N by N boxes as a boolean
+// satisfiability problem, with conflict-driven clause learning (CDCL).
+//
+// Every value of every cell is a variable, true if the cell has the value,
+// SIZE x SIZE x SIZE variables. The clauses say that every cell has a
+// value, and that every row, column, and NxN box has every value, 4 x SIZE
+// x SIZE clauses of SIZE literals. The rest of the encoding, that a cell
+// has one value and a unit has every value once, would take SIZE*(SIZE-1)/2
+// binary clauses per constraint, over a million for 25x25 sudoku. Those
+// are built into propagation instead: setting a variable to true sets the
+// other values of its cell, and its value in the peers of its cell, to
+// false, as forward checking does.
+//
+// The search is a standard CDCL solver:
+// - Clauses are watched by two of their literals, so a clause is only
+//   looked at when one of them becomes false.
+// - Every conflict is analysed back to its first unique implication point
+//   (1-UIP), and the clause learned from it makes the search jump back to
+//   the level where the clause implies a literal.
+// - The search branches on the unassigned variable with the highest
+//   activity (VSIDS). Variables in a conflict are bumped, and activities
+//   decay, so the search follows the recent conflicts. A variable gets the
+//   value it had last (phase saving).
+// - The search restarts after a number of conflicts that follows the Luby
+//   sequence, keeping what it learned.
+// - Clauses are stored one after the other in one array of 32 bit words,
+//   the arena. Once there are too many learned clauses, the less active
+//   half is dropped, and the arena is compacted.
+//
+// Learned clauses only hold for the puzzle they were learned on, so every
+// puzzle starts over from the rules alone.
+template <int N>
+class BasicSudokuSAT : public BasicSudokuSolver<N> {
+    using Board = BasicSudoku<N>;
+    static constexpr int SIZE = Board::SIZE;
+    static constexpr int NUM_CELLS = Board::NUM_CELLS;
+    static constexpr int NUM_VARS = NUM_CELLS * SIZE;
+
+    // Values of variables and literals.
+    static const std::int8_t FALSE = 0;
+    static const std::int8_t TRUE = 1;
+    static const std::int8_t UNASSIGNED = 2;
+
+    // Reason of a decision, or of a literal known from the puzzle.
+    static const int NO_REASON = -1;
+
+    // A clause watching a literal, and a literal of the clause, the
+    // blocker. If the blocker is true, the clause is satisfied and isn't
+    // looked at.
+    struct Watch {
+        int clause;
+        int blocker;
+    };
+
+    // Clauses, each a header word, the activity if it was learned, and its
+    // literals, see clauseSize. The clauses of the rules come first, and
+    // stay for every puzzle.
+    std::vector<std::uint32_t> arena;
+    int rulesSize = 0;
+
+    // Learned clauses, by their index in arena.
+    std::vector<int> learnts;
+
+    // Clauses watching every literal, the first two literals of a clause.
+    std::vector<std::vector<Watch>> watches;
+
+    // Value, decision level, and reason of every variable. The reason is
+    // the index of the clause that implied it, NO_REASON, or -2 - literal
+    // if a true literal of its cell or a peer ruled it out, see reasonOf.
+    std::vector<std::int8_t> values;
+    std::vector<int> levels;
+    std::vector<int> reasons;
+
+    // Value of every variable the last time it was assigned.
+    std::vector<std::int8_t> phases;
+
+    // Literals assigned, in order, and the size of trail at the start of
+    // every decision level. Literals from head on haven't been propagated.
+    std::vector<int> trail;
+    std::vector<int> trailLimits;
+    int head = 0;
+
+    // Activity of every variable, and a max heap of the variables by
+    // activity, with the index of every variable in heap, or -1.
+    std::vector<double> activities;
+    std::vector<int> heap;
+    std::vector<int> heapIndex;
+    double varIncrement = 1;
+    float clauseIncrement = 1;
+
+    // Most learned clauses before the less active half is dropped.
+    int maxLearnts = 0;
+
+    // Literals of the clause that failed propagation, all false, and its
+    // index in arena, or NO_REASON if a rule failed.
+    std::vector<int> conflict;
+    int conflictClause = NO_REASON;
+
+    // Scratch space of analyze.
+    std::vector<char> seen;
+    std::vector<int> learnt;
+
+    // Stats of the last search, see getStats.
+    SearchStats stats;
+
+    inline std::int8_t valueOf(int literal) const {
+        std::int8_t value = values[literal >> 1];
+        return value == UNASSIGNED ? value : static_cast<std::int8_t>(value ^ (literal & 1));
+    }
+
+    inline int decisionLevel() const {
+        return static_cast<int>(trailLimits.size());
+    }
+
+    // Clause layout in arena. The header of the clause at index c holds its
+    // size, whether it was dropped, and whether it was learned. Learned
+    // clauses have their activity, a float, after the header.
+    inline int clauseSize(int c) const {return static_cast<int>(arena[c] >> 2);}
+    inline bool isRemoved(int c) const {return (arena[c] & 2) != 0;}
+    inline bool isLearnt(int c) const {return (arena[c] & 1) != 0;}
+    inline std::uint32_t* clauseLiterals(int c) {return &arena[c + 1 + isLearnt(c)];}
+    inline const std::uint32_t* clauseLiterals(int c) const {
+        return &arena[c + 1 + isLearnt(c)];
+    }
+    inline int clauseEnd(int c) const {return c + 1 + isLearnt(c) + clauseSize(c);}
+    float getActivity(int c) const;
+    void setActivity(int c, float activity);
+
+    // Appends a clause of literals to arena, and watches its first two
+    // literals. Returns its index.
+    // requires: literals has >= 2 literals
+    int addClause(const std::vector<int> &literals, bool learnt);
+
+    inline void watch(int c) {
+        const std::uint32_t *literals = clauseLiterals(c);
+        watches[literals[0]].push_back(Watch{c, static_cast<int>(literals[1])});
+        watches[literals[1]].push_back(Watch{c, static_cast<int>(literals[0])});
+    }
+
+    // Assigns literal true at the current decision level.
+    // requires: literal is unassigned
+    void assign(int literal, int reason);
+
+    // Propagates the literals assigned since head. Returns false and sets
+    // conflict if a clause or a rule fails.
+    bool propagate();
+
+    // Calls visit with the other literals of the reason of variable, all
+    // false.
+    template <typename Visit>
+    void reasonOf(int variable, Visit visit) const;
+
+    // Learns a clause from conflict, and returns the level to go back to.
+    // The clause is left in learnt, with the literal it implies first.
+    int analyze();
+
+    // Undoes the assignments above level.
+    void backtrack(int level);
+
+    // Removes the less active half of the learned clauses that aren't the
+    // reason of an assignment, and compacts the arena.
+    void reduceLearnts();
+
+    void bumpVariable(int variable);
+    void bumpClause(int c);
+
+    void heapUp(int i);
+    void heapDown(int i);
+    void heapInsert(int variable);
+    int heapPop();
+
+    // Returns the literal to branch on next, or -1 if every variable is
+    // assigned.
+    int pickBranch();
+
+    // Sets up the search of board, and assigns its filled cells. Returns
+    // false if they break the rules.
+    bool reset(const Board& board);
+
+    // Searches for up to limit solutions of board, and returns the number
+    // found. Each solution found is written to board, and ruled out with a
+    // clause so the search finds the next. Gives up once budget runs out,
+    // and returns the solutions found so far. Sets stats to the work done.
+    // requires: limit >= 1
+    // effects: board may change
+    //          budget may change
+    int run(Board& board, int limit, SearchBudget &budget);
+
+public:
+    BasicSudokuSAT();
+
+    // Given a initial partially filled sudoku board, returns true if a
+    // solution exists, false otherwise. If a solution exists, then the board
+    // state will conatin the solution. The board is unchanged otherwise.
+    // effects: board may change
+    bool solve(Board& board) override;
+
+    // Same as solve, but gives up once limits are reached, see
+    // SudokuSolver::solveWithin. Every decision is a node. The board is
+    // unchanged unless solved.
+    // effects: board may change
+    SolveResult solveWithin(Board& board, const SearchLimits &limits) override;
+
+    int countSolutions(Board& board, int limit) override;
+
+    // Same as countSolutions, but gives up once limits are reached, see
+    // SudokuSolver::countWithin.
+    // effects: board may change
+    CountResult countWithin(Board& board, int limit, const SearchLimits &limits) override;
+
+    std::unique_ptr<BasicSudokuSolver<N>> clone() const override;
+
+    // Returns the stats of the last search. Nodes are decisions, backtracks
+    // are conflicts, and the values propagated are the literals implied.
+    // Always zero unless stats are enabled.
+    inline SearchStats getStats() const override {return stats;}
+};
+
+// CDCL solver for 9x9 sudoku.
+using SudokuSAT = BasicSudokuSAT<3>;
@@ -0,0 +1,390 @@
+#include "sudoku_server.h"
+
+#if SUDOKU_SERVER
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "sudoku_io.h"
+
+using namespace std;
+
+template <int N>
+struct BasicSudokuServer<N>::Connection {
+    int fd;
+    thread reader;
+
+    // Number of request lines read, to number requests without an ID.
+    long numRequests = 0;
+
+    // Requests queued or being solved, and set once the connection is
+    // closed. Guarded by the server mutex. answered is signalled when
+    // numPending reaches 0.
+    int numPending = 0;
+    bool closed = false;
+    condition_variable answered;
+
+    // Guards writes, so responses aren't interleaved, and broken, set once
+    // a write failed since the client is gone.
+    std::mutex writeMutex;
+    bool broken = false;
+
+    // Buffer for the invalid responses written by the reader.
+    string response;
+
+    // Cancelled once the client is gone or the server stops, to give up on
+    // the requests being solved.
+    CancelToken cancel;
+
+    explicit Connection(int fd) : fd(fd) {
+        response.reserve(MAX_ID_LENGTH + 16);
+    }
+};
+
+namespace {
+    // Time between checks for stopping while waiting to write a response, and
+    // for the client hanging up while waiting for its requests.
+    const int WRITE_POLL_MS = 100;
+
+    inline bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    string errorText(const string &what) {
+        return what + ": " + strerror(errno);
+    }
+}
+
+template <int N>
+BasicSudokuServer<N>::BasicSudokuServer(const string &path
+                                        , const BasicSudokuSolver<N> &solver
+                                        , int numThreads, int countLimit
+                                        , const SolveLimits &limits)
+    : path(path), countLimit(countLimit), limits(limits), queue(QUEUE_SIZE) {
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw runtime_error("Socket path " + path + " is too long");
+    }
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) throw runtime_error(errorText("Can't create socket"));
+
+    // Replace the socket of a server that didn't stop cleanly
+    struct stat info;
+    if (lstat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+        unlink(path.c_str());
+    }
+
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || listen(listenFd, SOMAXCONN) != 0) {
+        string error = errorText("Can't listen on " + path);
+        close(listenFd);
+        throw runtime_error(error);
+    }
+    if (pipe(stopPipe) != 0) {
+        string error = errorText("Can't create pipe");
+        close(listenFd);
+        unlink(path.c_str());
+        throw runtime_error(error);
+    }
+
+    if (numThreads <= 0) numThreads = max(1u, thread::hardware_concurrency());
+    for (int i=0; i<numThreads; ++i) {
+        workers.emplace_back(&BasicSudokuServer::work, this, solver.clone());
+    }
+}
+
+template <int N>
+BasicSudokuServer<N>::~BasicSudokuServer() {
+    stop();
+
+    // Readers close their connections once the workers finish or drop
+    // their requests
+    for (auto &connection : connections) {
+        connection->reader.join();
+    }
+    for (thread &worker : workers) {
+        worker.join();
+    }
+
+    close(listenFd);
+    close(stopPipe[0]);
+    close(stopPipe[1]);
+    unlink(path.c_str());
+}
+
+template <int N>
+void BasicSudokuServer<N>::run() {
+    pollfd fds[2] = {{listenFd, POLLIN, 0}, {stopPipe[0], POLLIN, 0}};
+
+    while (true) {
+        if (poll(fds, 2, -1) < 0 && errno != EINTR) {
+            throw runtime_error(errorText("Can't wait for connections"));
+        }
+
+        lock_guard<std::mutex> lock(mutex);
+        if (stopping) return;
+        if ((fds[0].revents & POLLIN) == 0) continue;
+
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) continue;
+#ifdef SO_NOSIGPIPE
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+        removeClosed();
+        connections.push_back(make_unique<Connection>(fd));
+        Connection &connection = *connections.back();
+        connection.reader = thread(&BasicSudokuServer::serve, this, ref(connection));
+    }
+}
+
+template <int N>
+void BasicSudokuServer<N>::stop() {
+    {
+        lock_guard<std::mutex> lock(mutex);
+        if (stopping) return;
+        stopping = true;
+
+        // Wake up the readers waiting for requests, and give up on the
+        // requests being solved
+        for (auto &connection : connections) {
+            connection->cancel.cancel();
+            if (!connection->closed) shutdown(connection->fd, SHUT_RD);
+        }
+    }
+    notEmpty.notify_all();
+    notFull.notify_all();
+
+    char byte = 0;
+    ssize_t written = write(stopPipe[1], &byte, 1);
+    (void)written;
+}
+
+template <int N>
+void BasicSudokuServer<N>::removeClosed() {
+    for (auto it = connections.begin(); it != connections.end(); ) {
+        if ((*it)->closed) {
+            (*it)->reader.join();
+            it = connections.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+template <int N>
+void BasicSudokuServer<N>::serve(Connection &connection) {
+    array<char, 1 << 16> buffer;
+    array<char, MAX_LINE_LENGTH> line;
+    int length = 0;
+
+    while (true) {
+        ssize_t size = read(connection.fd, buffer.data(), buffer.size());
+        if (size < 0 && errno == EINTR) continue;
+        if (size < 0) connection.cancel.cancel();
+        if (size <= 0) break;
+
+        for (ssize_t i=0; i<size; ++i) {
+            char c = buffer[i];
+            if (c == '\n') {
+                handleLine(connection, line.data(), length);
+                length = 0;
+            } else if (length >= 0 && length < MAX_LINE_LENGTH) {
+                line[length++] = c;
+            } else {
+                length = -1;
+            }
+        }
+
+        lock_guard<std::mutex> lock(mutex);
+        if (stopping) break;
+    }
+
+    // The last line may not end with a newline
+    if (length != 0) handleLine(connection, line.data(), length);
+
+    // Close once every request is answered. The client may only have
+    // stopped sending, so its requests are only cancelled once it hangs up.
+    unique_lock<std::mutex> lock(mutex);
+    while (!connection.answered.wait_for(lock, chrono::milliseconds(WRITE_POLL_MS)
+                                         , [&] {return connection.numPending == 0;})) {
+        pollfd fd = {connection.fd, 0, 0};
+        if (poll(&fd, 1, 0) > 0 && (fd.revents & (POLLHUP | POLLERR)) != 0) {
+            connection.cancel.cancel();
+        }
+    }
+    close(connection.fd);
+    connection.closed = true;
+}
+
+template <int N>
+void BasicSudokuServer<N>::handleLine(Connection &connection, const char *line
+                                      , int length) {
+    // Skip blank lines and comments
+    int begin = 0;
+    int end = length;
+    while (begin < end && isSpace(line[begin])) ++begin;
+    while (end > begin && isSpace(line[end-1])) --end;
+    if (length >= 0 && (begin == end || line[begin] == '#')) return;
+
+    ++connection.numRequests;
+
+    Request request;
+    request.connection = &connection;
+    bool valid = length >= 0;
+
+    // Split off the ID, if there is one
+    int puzzle = begin;
+    while (puzzle < end && !isSpace(line[puzzle])) ++puzzle;
+    if (puzzle < end) {
+        int idLength = min(puzzle - begin, MAX_ID_LENGTH);
+        memcpy(request.id.data(), line + begin, idLength);
+        request.idLength = idLength;
+        valid = valid && puzzle - begin <= MAX_ID_LENGTH;
+
+        while (puzzle < end && isSpace(line[puzzle])) ++puzzle;
+    } else {
+        request.idLength = snprintf(request.id.data(), MAX_ID_LENGTH, "%ld"
+                                    , connection.numRequests);
+        puzzle = begin;
+    }
+
+    // The puzzle is a single line of cells
+    valid = valid && end - puzzle == NUM_CELLS;
+    for (int i=0; valid && i<NUM_CELLS; ++i) {
+        int value = symbolValue(line[puzzle + i]);
+        if (value < 0 || value > SIZE) valid = false;
+        request.cells[i] = static_cast<uint8_t>(value);
+    }
+
+    if (!valid) {
+        connection.response.assign(request.id.data(), request.idLength);
+        connection.response += " invalid\n";
+        respond(connection, connection.response);
+        return;
+    }
+
+    unique_lock<std::mutex> lock(mutex);
+    notFull.wait(lock, [&] {return queueSize < QUEUE_SIZE || stopping;});
+    if (stopping) return;
+
+    queue[(queueHead + queueSize) % QUEUE_SIZE] = request;
+    ++queueSize;
+    ++connection.numPending;
+    notEmpty.notify_one();
+}
+
+template <int N>
+void BasicSudokuServer<N>::respond(Connection &connection, const string &response) {
+    lock_guard<std::mutex> lock(connection.writeMutex);
+    if (connection.broken) return;
+
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL | MSG_DONTWAIT;
+#else
+    const int flags = MSG_DONTWAIT;
+#endif
+
+    // Wait for a client that isn't reading its responses, but give up on it
+    // once the server stops
+    size_t written = 0;
+    while (written < response.size()) {
+        ssize_t size = send(connection.fd, response.data() + written
+                            , response.size() - written, flags);
+        if (size < 0 && errno == EINTR) continue;
+        if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && !stopping) {
+            pollfd fd = {connection.fd, POLLOUT, 0};
+            poll(&fd, 1, WRITE_POLL_MS);
+            continue;
+        }
+        if (size <= 0) {
+            connection.broken = true;
+            connection.cancel.cancel();
+            return;
+        }
+        written += static_cast<size_t>(size);
+    }
+}
+
+template <int N>
+void BasicSudokuServer<N>::work(unique_ptr<BasicSudokuSolver<N>> solver) {
+    BasicSudoku<N> board;
+    Request request;
+    string response;
+    response.reserve(MAX_ID_LENGTH + NUM_CELLS + 16);
+
+    while (true) {
+        {
+            unique_lock<std::mutex> lock(mutex);
+            notEmpty.wait(lock, [&] {return queueSize > 0 || stopping;});
+
+            // Drop the requests not started yet once stopping
+            if (stopping) {
+                for (; queueSize > 0; --queueSize) {
+                    Connection &connection = *queue[queueHead].connection;
+                    if (--connection.numPending == 0) connection.answered.notify_all();
+                    queueHead = (queueHead + 1) % QUEUE_SIZE;
+                }
+                return;
+            }
+
+            request = queue[queueHead];
+            queueHead = (queueHead + 1) % QUEUE_SIZE;
+            --queueSize;
+        }
+        notFull.notify_one();
+
+        board.loadCells(request.cells.data());
+
+        Connection &connection = *request.connection;
+        SolveResult result = SolveResult::Solved;
+
+        response.assign(request.id.data(), request.idLength);
+        response.push_back(' ');
+        if (countLimit > 0) {
+            CountResult counted = solver->countWithin(board, countLimit
+                                                      , limits.start(&connection.cancel));
+            result = counted.result;
+            if (result == SolveResult::Solved || result == SolveResult::Unsolvable) {
+                char count[16];
+                snprintf(count, sizeof(count), "%d", counted.count);
+                response += count;
+            } else {
+                response += "timeout";
+            }
+        } else {
+            result = solver->solveWithin(board, limits.start(&connection.cancel));
+            if (result == SolveResult::Solved) {
+                appendLine(response, board);
+            } else if (result == SolveResult::Unsolvable) {
+                response += "unsolvable";
+            } else {
+                response += "timeout";
+            }
+        }
+        response.push_back('\n');
+
+        // Nobody is waiting for a cancelled request
+        if (result != SolveResult::Cancelled) respond(connection, response);
+
+        lock_guard<std::mutex> lock(mutex);
+        if (--connection.numPending == 0) connection.answered.notify_all();
+    }
+}
+
+template class BasicSudokuServer<3>;
+template class BasicSudokuServer<4>;
+template class BasicSudokuServer<5>;
+
+#endif
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "sudoku_solver.h"
+
+// The server needs POSIX sockets, so it's only built on Unix like systems.
+#if defined(__unix__) || defined(__APPLE__)
+#define SUDOKU_SERVER 1
+#else
+#define SUDOKU_SERVER 0
+#endif
+
+#if SUDOKU_SERVER
+
+// BasicSudokuServer solves sudoku puzzles with N by N boxes sent by clients
+// over a Unix domain socket, so a long running process can answer many
+// clients without starting a solver per puzzle.
+//
+// Requests and responses are lines of text. A request is a puzzle written
+// as a single line of SIZE*SIZE symbols, see symbolValue, optionally
+// preceded by a request ID and a space:
+//     42 003020600900305001001806400008102900...
+// Without an ID, the request gets its number on the connection, counting
+// from 1. Blank lines and lines starting with # are skipped. Every request
+// gets one response line, its ID, a space, and the solution as a line of
+// symbols, "unsolvable", "timeout" if solving reached the limits of the
+// server, or "invalid" if the request couldn't be read. If solutions are
+// counted, the response has the number of solutions instead. Requests of a
+// client that hangs up are cancelled, and get no response.
+//
+// Clients can send many requests without waiting for the responses. The
+// requests of all connections are queued and solved by a fixed set of
+// workers, each with its own solver and board, so a response can come
+// before the responses of earlier requests. Requests and responses go
+// through buffers allocated up front, so solving a request doesn't
+// allocate memory.
+template <int N>
+class BasicSudokuServer {
+public:
+    static constexpr int SIZE = BasicSudoku<N>::SIZE;
+    static constexpr int NUM_CELLS = BasicSudoku<N>::NUM_CELLS;
+
+    // Longest request ID, and longest request line.
+    static constexpr int MAX_ID_LENGTH = 64;
+    static constexpr int MAX_LINE_LENGTH = NUM_CELLS + MAX_ID_LENGTH + 64;
+
+    // Most requests queued at once, over all connections. Connections wait
+    // to read more requests while the queue is full.
+    static constexpr int QUEUE_SIZE = 1024;
+
+private:
+    struct Connection;
+
+    // A puzzle read from a connection and waiting for a worker.
+    struct Request {
+        Connection *connection;
+        std::array<char, MAX_ID_LENGTH> id;
+        int idLength;
+        std::array<std::uint8_t, NUM_CELLS> cells;
+    };
+
+    std::string path;
+    int listenFd;
+    int countLimit;
+    SolveLimits limits;
+
+    // Pipe written by stop to wake up run.
+    int stopPipe[2];
+
+    // Guards everything below, and the pending requests of connections.
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+
+    // Ring buffer of queued requests.
+    std::vector<Request> queue;
+    int queueHead = 0;
+    int queueSize = 0;
+
+    // True once stop is called. Only set while holding mutex, but can be
+    // read without it.
+    std::atomic<bool> stopping{false};
+
+    std::list<std::unique_ptr<Connection>> connections;
+    std::vector<std::thread> workers;
+
+    // Solves queued requests with solver until the server stops.
+    void work(std::unique_ptr<BasicSudokuSolver<N>> solver);
+
+    // Reads the requests of connection and queues them until the client
+    // closes it or the server stops. Closes it once every request is
+    // answered.
+    void serve(Connection &connection);
+
+    // Parses a request line of connection and queues it, or writes an
+    // invalid response if it isn't a puzzle. A length of -1 means the line
+    // was too long. Waits while the queue is full.
+    void handleLine(Connection &connection, const char *line, int length);
+
+    // Writes response to connection, unless its client is gone. Cancels the
+    // requests of connection if it is.
+    void respond(Connection &connection, const std::string &response);
+
+    // Joins and removes the connections that were closed.
+    void removeClosed();
+
+public:
+    // Creates a server listening on the socket at path, answering with
+    // clones of solver on numThreads workers, or one per hardware thread if
+    // numThreads <= 0. If countLimit > 0, counts solutions up to countLimit
+    // instead of solving. Gives up on puzzles that reach limits.
+    // Replaces an old socket at path. Throws runtime_error if the socket
+    // can't be created.
+    BasicSudokuServer(const std::string &path, const BasicSudokuSolver<N> &solver
+                      , int numThreads, int countLimit
+                      , const SolveLimits &limits = SolveLimits());
+
+    // Stops the server, and removes the socket.
+    ~BasicSudokuServer();
+
+    BasicSudokuServer(const BasicSudokuServer&) = delete;
+    BasicSudokuServer& operator=(const BasicSudokuServer&) = delete;
+
+    // Accepts connections until stop is called.
+    void run();
+
+    // Makes run return, and closes every connection. Requests being solved
+    // are cancelled, and the other queued requests are dropped. Can be
+    // called from any thread.
+    void stop();
+
+    // Returns the number of workers.
+    inline int getNumThreads() const {
+        return static_cast<int>(workers.size());
+    }
+};
+
+// Server of 9x9 sudoku.
+using SudokuServer = BasicSudokuServer<3>;
+
+#endif
@@ -0,0 +1,211 @@
+#include "sudoku_simd.h"
+#include <cassert>
+
+#if SUDOKU_SIMD
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace simd {
+
+#if SUDOKU_SIMD
+namespace {
+    bool supportsAvx2() {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+    }
+
+    // Most vectors of a board, for 16x16 sudoku.
+    constexpr int MAX_VECTORS = 256 / LANES;
+
+    // Returns the number of set bits of every 16 bit lane of v. Counts the
+    // bits of every nibble with a lookup table, then adds up the nibbles.
+    __attribute__((target("avx2")))
+    inline __m256i popcount16(__m256i v) {
+        const __m256i nibbleCounts = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+                                                      , 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i lowNibbles = _mm256_set1_epi8(0x0F);
+
+        __m256i low = _mm256_shuffle_epi8(nibbleCounts, _mm256_and_si256(v, lowNibbles));
+        __m256i high = _mm256_shuffle_epi8(nibbleCounts
+                                           , _mm256_and_si256(_mm256_srli_epi16(v, 4), lowNibbles));
+        __m256i bytes = _mm256_add_epi8(low, high);
+        return _mm256_add_epi16(_mm256_and_si256(bytes, _mm256_set1_epi16(0x00FF))
+                                , _mm256_srli_epi16(bytes, 8));
+    }
+
+    // Returns all ones in the lanes of the cells that are empty, loading the
+    // 16 states at state.
+    __attribute__((target("avx2")))
+    inline __m256i emptyLanes(const uint8_t *state) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state));
+        return _mm256_cmpeq_epi16(_mm256_cvtepu8_epi16(bytes), _mm256_setzero_si256());
+    }
+
+    // Returns one bit per lane of v, where every lane is all ones or zero.
+    __attribute__((target("avx2")))
+    inline uint16_t laneBits(__m256i v) {
+        __m128i bytes = _mm_packs_epi16(_mm256_castsi256_si128(v)
+                                        , _mm256_extracti128_si256(v, 1));
+        return static_cast<uint16_t>(_mm_movemask_epi8(bytes));
+    }
+}
+
+bool active = supportsAvx2();
+
+void setEnabled(bool enable) {
+    active = enable && supportsAvx2();
+}
+
+__attribute__((target("avx2")))
+int findFewestValues(const uint8_t *state, const uint16_t *values
+                     , int numLanes, uint16_t *cells) {
+    assert(numLanes % LANES == 0 && numLanes <= MAX_VECTORS * LANES);
+
+    const int numVectors = numLanes / LANES;
+    const __m256i allOnes = _mm256_set1_epi16(-1);
+
+    // Number of possible values of every empty cell, and 0xFFFF for the
+    // filled cells, so they're never the minimum
+    __m256i counts[MAX_VECTORS];
+    __m256i minCounts = allOnes;
+    for (int i=0; i<numVectors; ++i) {
+        __m256i masks = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i*LANES));
+        __m256i filled = _mm256_andnot_si256(emptyLanes(state + i*LANES), allOnes);
+        counts[i] = _mm256_or_si256(popcount16(masks), filled);
+        minCounts = _mm256_min_epu16(minCounts, counts[i]);
+    }
+
+    // Reduce to the minimum of all lanes
+    __m128i halves = _mm_min_epu16(_mm256_castsi256_si128(minCounts)
+                                   , _mm256_extracti128_si256(minCounts, 1));
+    int minCount = _mm_cvtsi128_si32(_mm_minpos_epu16(halves)) & 0xFFFF;
+    if (minCount == 0xFFFF) return -1;
+
+    const __m256i target = _mm256_set1_epi16(static_cast<short>(minCount));
+    for (int i=0; i<numVectors; ++i) {
+        cells[i] = laneBits(_mm256_cmpeq_epi16(counts[i], target));
+    }
+    return minCount;
+}
+
+__attribute__((target("avx2")))
+bool removeFromPeers(const uint8_t *state, uint16_t *values
+                     , const uint16_t *peers, int numLanes
+                     , uint16_t bit, uint16_t *removed) {
+    assert(numLanes % LANES == 0);
+
+    const __m256i laneMasks = _mm256_setr_epi16(0x0001, 0x0002, 0x0004, 0x0008
+                                                , 0x0010, 0x0020, 0x0040, 0x0080
+                                                , 0x0100, 0x0200, 0x0400, 0x0800
+                                                , 0x1000, 0x2000, 0x4000, -0x8000);
+    const __m256i bits = _mm256_set1_epi16(static_cast<short>(bit));
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i failed = zero;
+
+    for (int i=0; i<numLanes/LANES; ++i) {
+        __m256i *lanes = reinterpret_cast<__m256i*>(values + i*LANES);
+
+        // Spread the peer bits to all ones in the lanes of the peers
+        __m256i peerBits = _mm256_and_si256(_mm256_set1_epi16(static_cast<short>(peers[i])), laneMasks);
+        __m256i isPeer = _mm256_cmpeq_epi16(peerBits, laneMasks);
+
+        __m256i masks = _mm256_loadu_si256(lanes);
+        __m256i hadBit = _mm256_cmpeq_epi16(_mm256_and_si256(masks, bits), bits);
+        removed[i] = laneBits(_mm256_and_si256(hadBit, isPeer));
+
+        masks = _mm256_andnot_si256(_mm256_and_si256(isPeer, bits), masks);
+        _mm256_storeu_si256(lanes, masks);
+
+        // Empty peers without possible values
+        __m256i wipedOut = _mm256_and_si256(_mm256_cmpeq_epi16(masks, zero)
+                                            , emptyLanes(state + i*LANES));
+        failed = _mm256_or_si256(failed, _mm256_and_si256(wipedOut, isPeer));
+    }
+    return _mm256_testz_si256(failed, failed) != 0;
+}
+
+namespace {
+    // Returns all ones in the lanes of masks with exactly one value.
+    __attribute__((target("avx2")))
+    inline __m256i singleLanes(__m256i masks) {
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i lowestCleared = _mm256_and_si256(masks, _mm256_sub_epi16(masks, _mm256_set1_epi16(1)));
+        return _mm256_andnot_si256(_mm256_cmpeq_epi16(masks, zero)
+                                   , _mm256_cmpeq_epi16(lowestCleared, zero));
+    }
+}
+
+__attribute__((target("avx2")))
+uint16_t propagateSingles(uint16_t *masks, const uint16_t *units, int numUnits
+                          , int size, uint16_t allValues) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(-1);
+    const __m256i all = _mm256_set1_epi16(static_cast<short>(allValues));
+
+    // Lanes that broke the rules, and lanes with cells left to fill
+    __m256i failed = zero;
+    __m256i unfilled = zero;
+    bool changed = true;
+
+    while (changed) {
+        changed = false;
+        unfilled = zero;
+
+        for (int u=0; u<numUnits; ++u) {
+            const uint16_t *unit = units + u*size;
+
+            // Values of the filled cells, the values filled twice, every
+            // possible value, and the values possible in two cells or more
+            __m256i filled = zero;
+            __m256i filledTwice = zero;
+            __m256i possible = zero;
+            __m256i possibleTwice = zero;
+            for (int i=0; i<size; ++i) {
+                __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(masks + unit[i]*LANES));
+                __m256i single = singleLanes(m);
+                __m256i value = _mm256_and_si256(m, single);
+                filledTwice = _mm256_or_si256(filledTwice, _mm256_and_si256(filled, value));
+                filled = _mm256_or_si256(filled, value);
+                possibleTwice = _mm256_or_si256(possibleTwice, _mm256_and_si256(possible, m));
+                possible = _mm256_or_si256(possible, m);
+                unfilled = _mm256_or_si256(unfilled, _mm256_andnot_si256(single, ones));
+            }
+
+            // The unit breaks the rules if a value is filled twice, or has
+            // no cell left
+            __m256i valid = _mm256_and_si256(_mm256_cmpeq_epi16(filledTwice, zero)
+                                             , _mm256_cmpeq_epi16(possible, all));
+            failed = _mm256_or_si256(failed, _mm256_andnot_si256(valid, ones));
+            __m256i once = _mm256_andnot_si256(possibleTwice, possible);
+
+            // Remove the filled values from the other cells, and keep only
+            // the value of a hidden single, a value possible in one cell
+            __m256i diff = zero;
+            for (int i=0; i<size; ++i) {
+                __m256i *lanes = reinterpret_cast<__m256i*>(masks + unit[i]*LANES);
+                __m256i m = _mm256_loadu_si256(lanes);
+                __m256i left = _mm256_andnot_si256(filled, m);
+                __m256i hidden = _mm256_and_si256(left, once);
+                left = _mm256_blendv_epi8(hidden, left, _mm256_cmpeq_epi16(hidden, zero));
+                left = _mm256_blendv_epi8(left, m, singleLanes(m));
+                diff = _mm256_or_si256(diff, _mm256_xor_si256(left, m));
+                _mm256_storeu_si256(lanes, left);
+            }
+            if (!_mm256_testz_si256(diff, diff)) changed = true;
+        }
+    }
+
+    return laneBits(_mm256_andnot_si256(_mm256_or_si256(failed, unfilled), ones));
+}
+
+#else
+
+bool active = false;
+
+void setEnabled(bool) {}
+
+#endif
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+
+// Vectorized scans over the whole board, for boards with 16 bit masks, 9x9
+// and 16x16 sudoku. Every cell is one 16 bit lane, so a vector holds 16
+// cells. The board arrays are padded to whole vectors, and the padding
+// cells are filled and have no possible values.
+//
+// The routines use AVX2, and are only compiled for x86 with GCC or Clang,
+// where SUDOKU_SIMD is 1. They're picked at run time: callers check
+// simd::enabled() first, and use their scalar loops if it's false.
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SUDOKU_SIMD 1
+#else
+#define SUDOKU_SIMD 0
+#endif
+
+namespace simd {
+    // Number of cells in one vector.
+    constexpr int LANES = 16;
+
+    // True if the vectorized routines are used. Don't read directly, use
+    // enabled().
+    extern bool active;
+
+    // Returns true if the CPU supports AVX2 and the vectorized routines
+    // weren't turned off.
+    inline bool enabled() {
+        return active;
+    }
+
+    // Turns the vectorized routines on or off, ex. to compare them with the
+    // scalar loops. They stay off if the CPU doesn't support AVX2. Not
+    // thread safe, call before solving.
+    void setEnabled(bool enable);
+
+#if SUDOKU_SIMD
+    // Sets bit i of cells[w] if cell 16*w + i is empty and has the fewest
+    // possible values of all the empty cells. state and values hold
+    // numLanes cells, and cells has numLanes/16 words. Returns the number of
+    // possible values of those cells, or -1 if no cell is empty.
+    // requires: numLanes is a multiple of 16, at most 256
+    int findFewestValues(const std::uint8_t *state, const std::uint16_t *values
+                         , int numLanes, std::uint16_t *cells);
+
+    // Removes bit from the possible values of the cells set in the bitmap
+    // peers, and sets the cells that had bit in the bitmap removed. Returns
+    // false if one of the peers is empty and has no possible values left,
+    // true otherwise.
+    // requires: numLanes is a multiple of 16
+    bool removeFromPeers(const std::uint8_t *state, std::uint16_t *values
+                         , const std::uint16_t *peers, int numLanes
+                         , std::uint16_t bit, std::uint16_t *removed);
+
+    // Fills in naked and hidden singles on 16 puzzles at once, one per lane,
+    // until none are left. masks holds the possible values of every cell,
+    // cell by cell, 16 lanes per cell, where filled cells hold their value.
+    // units holds numUnits units of size cells. Returns one bit per lane set
+    // if every cell of its puzzle was filled without breaking the rules.
+    // requires: the masks of filled cells have one value
+    std::uint16_t propagateSingles(std::uint16_t *masks, const std::uint16_t *units
+                                   , int numUnits, int size, std::uint16_t allValues);
+#endif
+}
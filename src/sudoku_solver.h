@@ -0,0 +1,87 @@
+#pragma once
+
+#include <memory>
+#include "search_limits.h"
+#include "search_stats.h"
+#include "sudoku.h"
+
+// Result of counting solutions within limits, see
+// BasicSudokuSolver::countWithin.
+struct CountResult {
+    // Number of solutions found. Only a lower bound if the count gave up.
+    int count = 0;
+
+    // Solved if at least one solution was found, Unsolvable if there is
+    // none, or TimedOut or Cancelled if the count gave up before finishing.
+    SolveResult result = SolveResult::Unsolvable;
+};
+
+// Returns the result of a search that found count solutions, counting up to
+// limit, with budget. A count that reached limit finished, even if budget
+// ran out right after.
+inline CountResult makeCountResult(int count, int limit, const SearchBudget &budget) {
+    CountResult counted;
+    counted.count = count;
+    if (count < limit && budget.isStopped()) {
+        counted.result = budget.getReason();
+    } else {
+        counted.result = count > 0 ? SolveResult::Solved : SolveResult::Unsolvable;
+    }
+    return counted;
+}
+
+// BasicSudokuSolver is the interface shared by the engines that solve sudoku
+// puzzles with N by N boxes, so they can be swapped and compared.
+// A solver may keep working memory between calls to solve, so one solver
+// shouldn't be used from multiple threads at once. Use clone to get a
+// solver for another thread.
+template <int N>
+class BasicSudokuSolver {
+public:
+    virtual ~BasicSudokuSolver() = default;
+
+    // Given a initial partially filled sudoku board, returns true if a
+    // solution exists, false otherwise. If a solution exists, then the board
+    // state will conatin the solution. It will contain garbage values otherwise.
+    // effects: board may change
+    virtual bool solve(BasicSudoku<N>& board) = 0;
+
+    // Same as solve, but gives up once limits are reached, and returns
+    // TimedOut or Cancelled. The board contains garbage values unless the
+    // result is Solved. Engines that can't give up ignore the limits.
+    // effects: board may change
+    virtual SolveResult solveWithin(BasicSudoku<N>& board, const SearchLimits &limits) {
+        (void)limits;
+        return solve(board) ? SolveResult::Solved : SolveResult::Unsolvable;
+    }
+
+    // Returns the number of solutions of board, counting up to limit. Stops
+    // searching as soon as limit solutions are found, so a limit of 2 checks
+    // whether board has a unique solution. If limit solutions are found,
+    // the board state contains the last one.
+    // effects: board may change
+    virtual int countSolutions(BasicSudoku<N>& board, int limit) = 0;
+
+    // Same as countSolutions, but gives up once limits are reached, and
+    // returns the solutions found so far with TimedOut or Cancelled.
+    // Engines that can't give up ignore the limits.
+    // effects: board may change
+    virtual CountResult countWithin(BasicSudoku<N>& board, int limit
+                                    , const SearchLimits &limits) {
+        (void)limits;
+        CountResult counted;
+        counted.count = countSolutions(board, limit);
+        counted.result = counted.count > 0 ? SolveResult::Solved : SolveResult::Unsolvable;
+        return counted;
+    }
+
+    // Returns a new solver with the same settings.
+    virtual std::unique_ptr<BasicSudokuSolver> clone() const = 0;
+
+    // Returns the stats of the last search. Engines that don't collect stats
+    // return zero stats.
+    virtual SearchStats getStats() const {return SearchStats();}
+};
+
+// The interface of the engines that solve 9x9 sudoku.
+using SudokuSolver = BasicSudokuSolver<3>;
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Lookup tables of the cells that constrain each other in a sudoku with N by
+// N boxes, computed at compile time. Cells are numbered column by column,
+// so with SIZE = N*N, cell (x, y) is number x*SIZE + y.
+//
+// Routines that visit the row, column, and box of a cell loop over these
+// tables instead of computing the box bounds, so the loops have a fixed
+// length and no divisions.
+
+// Cell numbers fit in 16 bits for every supported size.
+using CellIndex = std::uint16_t;
+
+// Returns the number of other cells sharing a row, column, or box with a
+// cell. ex. 20 for 9x9 sudoku.
+template <int N>
+constexpr int numPeers() {
+    return 2 * (N*N - 1) + (N - 1) * (N - 1);
+}
+
+// Returns the number of units, the rows, columns, and boxes.
+template <int N>
+constexpr int numUnits() {
+    return 3 * N * N;
+}
+
+// Returns the number of cells rounded up to a multiple of 16, so the board
+// arrays hold whole vectors of 16 bit lanes.
+template <int N>
+constexpr int numLanes() {
+    return (N*N*N*N + 15) / 16 * 16;
+}
+
+template <int N>
+using PeerTable = std::array<std::array<CellIndex, numPeers<N>()>, N*N*N*N>;
+
+template <int N>
+using UnitTable = std::array<std::array<CellIndex, N*N>, numUnits<N>()>;
+
+// Returns the table of the peers of every cell, the other cells in the same
+// row, column, or box. The peers of a cell are its box, left to right then
+// top to bottom, then the rest of its row, then the rest of its column.
+template <int N>
+constexpr PeerTable<N> makePeerTable() {
+    constexpr int SIZE = N * N;
+    PeerTable<N> peers{};
+
+    for (int y=0; y<SIZE; ++y) {
+        for (int x=0; x<SIZE; ++x) {
+            auto &cellPeers = peers[x*SIZE + y];
+            int minX = x/N*N;
+            int minY = y/N*N;
+            int k = 0;
+
+            for (int i = minX; i < minX+N; ++i) {
+                for (int j = minY; j < minY+N; ++j) {
+                    if (i != x || j != y) cellPeers[k++] = static_cast<CellIndex>(i*SIZE + j);
+                }
+            }
+            for (int i=0; i<SIZE; ++i) {
+                if (i/N*N != minX) cellPeers[k++] = static_cast<CellIndex>(i*SIZE + y);
+            }
+            for (int j=0; j<SIZE; ++j) {
+                if (j/N*N != minY) cellPeers[k++] = static_cast<CellIndex>(x*SIZE + j);
+            }
+        }
+    }
+    return peers;
+}
+
+template <int N>
+using PeerBitTable = std::array<std::array<std::uint16_t, numLanes<N>() / 16>, N*N*N*N>;
+
+// Returns the peers of every cell as a bitmap, for vector loops. Bit i of
+// word w is set if cell 16*w + i is a peer.
+template <int N>
+constexpr PeerBitTable<N> makePeerBitTable() {
+    const PeerTable<N> peers = makePeerTable<N>();
+    PeerBitTable<N> bits{};
+
+    for (int cell=0; cell<N*N*N*N; ++cell) {
+        for (CellIndex peer : peers[cell]) {
+            bits[cell][peer / 16] |= static_cast<std::uint16_t>(1u << (peer % 16));
+        }
+    }
+    return bits;
+}
+
+// Returns the table of the cells of every unit. Units 0 to SIZE-1 are the
+// rows, SIZE to 2*SIZE-1 are the columns, and the rest are the boxes, left
+// to right then top to bottom. Cells of a row or column are in order, and
+// cells of a box are left to right, then top to bottom.
+template <int N>
+constexpr UnitTable<N> makeUnitTable() {
+    constexpr int SIZE = N * N;
+    UnitTable<N> units{};
+
+    for (int u=0; u<SIZE; ++u) {
+        for (int i=0; i<SIZE; ++i) {
+            units[u][i] = static_cast<CellIndex>(i*SIZE + u);
+            units[SIZE + u][i] = static_cast<CellIndex>(u*SIZE + i);
+
+            int x = u%N*N + i%N;
+            int y = u/N*N + i/N;
+            units[2*SIZE + u][i] = static_cast<CellIndex>(x*SIZE + y);
+        }
+    }
+    return units;
+}
+
+template <int N>
+using CellUnitTable = std::array<std::array<std::uint8_t, 3>, N*N*N*N>;
+
+// Returns the units of every cell, its row, column, and box, numbered as in
+// makeUnitTable.
+template <int N>
+constexpr CellUnitTable<N> makeCellUnitTable() {
+    constexpr int SIZE = N * N;
+    CellUnitTable<N> cellUnits{};
+
+    for (int x=0; x<SIZE; ++x) {
+        for (int y=0; y<SIZE; ++y) {
+            auto &units = cellUnits[x*SIZE + y];
+            units[0] = static_cast<std::uint8_t>(y);
+            units[1] = static_cast<std::uint8_t>(SIZE + x);
+            units[2] = static_cast<std::uint8_t>(2*SIZE + y/N*N + x/N);
+        }
+    }
+    return cellUnits;
+}
+
+// The tables for sudoku with N by N boxes.
+template <int N>
+struct SudokuTables {
+    static constexpr int NUM_PEERS = numPeers<N>();
+    static constexpr int NUM_UNITS = numUnits<N>();
+
+    static constexpr PeerTable<N> PEERS = makePeerTable<N>();
+    static constexpr UnitTable<N> UNITS = makeUnitTable<N>();
+    static constexpr CellUnitTable<N> CELL_UNITS = makeCellUnitTable<N>();
+    static constexpr PeerBitTable<N> PEER_BITS = makePeerBitTable<N>();
+};
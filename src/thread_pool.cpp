@@ -0,0 +1,116 @@
+#include "thread_pool.h"
+
+using namespace std;
+
+namespace {
+    // Pool and index of the worker running on the current thread.
+    thread_local const ThreadPool *currentPool = nullptr;
+    thread_local int currentIndex = -1;
+}
+
+ThreadPool::ThreadPool(int numThreads)
+    : numPending(0), stopping(false), nextQueue(0) {
+
+    if (numThreads <= 0) numThreads = defaultNumThreads();
+
+    for (int i=0; i<numThreads; ++i) {
+        queues.push_back(make_unique<Queue>());
+    }
+    for (int i=0; i<numThreads; ++i) {
+        threads.emplace_back(&ThreadPool::run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+
+    for (thread &t : threads) {
+        t.join();
+    }
+}
+
+int ThreadPool::defaultNumThreads() {
+    int n = static_cast<int>(thread::hardware_concurrency());
+    return n > 0 ? n : 1;
+}
+
+int ThreadPool::getWorkerIndex() const {
+    return currentPool == this ? currentIndex : -1;
+}
+
+void ThreadPool::submit(Task task) {
+    int index = getWorkerIndex();
+    bool outside = index == -1;
+
+    // Tasks from outside the pool are spread over the queues
+    if (outside) {
+        lock_guard<std::mutex> lock(mutex);
+        index = nextQueue++ % queues.size();
+    }
+
+    {
+        lock_guard<std::mutex> lock(queues[index]->mutex);
+        if (outside) {
+            queues[index]->outsideTasks.push_back(move(task));
+        } else {
+            queues[index]->ownTasks.push_back(move(task));
+        }
+    }
+    {
+        lock_guard<std::mutex> lock(mutex);
+        ++numPending;
+    }
+    wakeUp.notify_one();
+}
+
+bool ThreadPool::take(int index, Task &task) {
+    int numQueues = static_cast<int>(queues.size());
+
+    // Check own queue first, newest own task first, then the oldest outside
+    // task. Then steal the oldest task of other queues, outside tasks first
+    // to keep them in order.
+    for (int i=0; i<numQueues; ++i) {
+        Queue &queue = *queues[(index + i) % numQueues];
+        lock_guard<std::mutex> lock(queue.mutex);
+
+        if (i == 0 && !queue.ownTasks.empty()) {
+            task = move(queue.ownTasks.back());
+            queue.ownTasks.pop_back();
+        } else if (!queue.outsideTasks.empty()) {
+            task = move(queue.outsideTasks.front());
+            queue.outsideTasks.pop_front();
+        } else if (!queue.ownTasks.empty()) {
+            task = move(queue.ownTasks.front());
+            queue.ownTasks.pop_front();
+        } else {
+            continue;
+        }
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run(int index) {
+    currentPool = this;
+    currentIndex = index;
+
+    Task task;
+    while (true) {
+        {
+            unique_lock<std::mutex> lock(mutex);
+            wakeUp.wait(lock, [this] { return numPending > 0 || stopping; });
+            if (numPending == 0) return;
+            --numPending;
+        }
+
+        // A task is reserved for this worker, so one is in some queue
+        while (!take(index, task)) {}
+
+        task();
+        task = nullptr;
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ThreadPool runs tasks on a fixed number of worker threads. Every worker
+// has its own deques of tasks. Tasks submitted from a worker go on that
+// worker's deque of its own tasks, and the worker runs them newest first,
+// so it finishes the work it split off before starting something else.
+// Tasks submitted from other threads are spread over the workers' deques of
+// outside tasks, and run oldest first, in the order they were submitted.
+// A worker with both deques empty steals the oldest task of another
+// worker.
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+private:
+    // Deques of tasks owned by one worker: the tasks it submitted itself,
+    // and the tasks submitted from outside the pool
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> ownTasks;
+        std::deque<Task> outsideTasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+
+    // Guards changes to numPending and stopping, and is used to put idle
+    // workers to sleep on wakeUp.
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+
+    // Number of tasks submitted but not yet taken by a worker. Only changed
+    // while holding mutex, but can be read without it.
+    std::atomic<int> numPending;
+
+    // True when the pool is being destroyed.
+    bool stopping;
+
+    // Queue that the next task submitted from outside the pool goes on.
+    unsigned nextQueue;
+
+    // Runs tasks on worker index until the pool is destroyed.
+    void run(int index);
+
+    // Takes the newest own task or the oldest outside task of queue index,
+    // or steals the oldest task of another queue. Returns true if a task
+    // was taken.
+    // effects: task may change
+    bool take(int index, Task &task);
+
+public:
+    // Creates a pool with numThreads workers. If numThreads <= 0, creates
+    // one worker per hardware thread.
+    explicit ThreadPool(int numThreads = 0);
+
+    // Runs the remaining tasks, then stops the workers.
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Queues task to run on some worker.
+    void submit(Task task);
+
+    // Returns the number of workers.
+    inline int getNumThreads() const {
+        return static_cast<int>(threads.size());
+    }
+
+    // Returns the number of tasks waiting for a worker. Only a hint, since
+    // workers may take tasks at any time.
+    inline int getNumQueued() const {
+        return numPending.load(std::memory_order_relaxed);
+    }
+
+    // Returns the index of the calling worker, from 0 to getNumThreads() - 1,
+    // or -1 if the caller isn't a worker of this pool.
+    int getWorkerIndex() const;
+
+    // Returns the default number of workers, the number of hardware threads.
+    static int defaultNumThreads();
+};
@@ -0,0 +1,104 @@
+// Checks that batch mode writes the right line for every puzzle, in input
+// order, when invalid puzzles start groups and the input is larger than the
+// window, so slots are reused while groups are still being solved.
+
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "batch.h"
+#include "sudoku_backtrack.h"
+
+using namespace std;
+
+namespace {
+    // Solved by singles, so by the lockstep solver
+    const char *EASY = ".2......868..7.5...5946..215.7.864..398...6.5.6.3.5.7924...91...3..249.7..6...24.";
+
+    // Needs a guess, so solved by the engine
+    const char *HARD = "4.....8.5.3..........7......2.....6.....8.4......1.......6.3.7.5..2.....1.4......";
+
+    // The last cell of the first row can't be 9
+    const char *UNSOLVABLE = "12345678.........9...............................................................";
+
+    // Too few cells
+    const char *INVALID = "12345";
+
+    const int NUM_PUZZLES = 20000;
+
+    // Returns the line batch mode writes for puzzle.
+    string expected(const char *puzzle) {
+        if (puzzle == INVALID) return "invalid";
+
+        istringstream in(puzzle);
+        PuzzleReader reader(in);
+        Sudoku board;
+        reader.next(board);
+        SudokuBacktrack solver;
+        if (!solver.solve(board)) return "unsolvable";
+
+        string line;
+        appendLine(line, board);
+        return line;
+    }
+}
+
+int main() {
+    // Every 16th puzzle, the first of a group, is invalid
+    vector<const char*> puzzles;
+    for (int i=0; i<NUM_PUZZLES; ++i) {
+        if (i % 16 == 0) {
+            puzzles.push_back(INVALID);
+        } else if (i % 97 == 0) {
+            puzzles.push_back(UNSOLVABLE);
+        } else if (i % 61 == 0) {
+            puzzles.push_back(HARD);
+        } else {
+            puzzles.push_back(EASY);
+        }
+    }
+
+    // Solve each kind of puzzle once
+    map<const char*, string> lines;
+    for (const char *puzzle : {EASY, HARD, UNSOLVABLE, INVALID}) {
+        lines[puzzle] = expected(puzzle);
+    }
+
+    string input;
+    for (const char *puzzle : puzzles) {
+        input += puzzle;
+        input.push_back('\n');
+    }
+
+    for (int numThreads : {1, 2, 4}) {
+        istringstream in(input);
+        PuzzleReader reader(in);
+        ostringstream out;
+        ostringstream err;
+        ThreadPool pool(numThreads);
+        SudokuBacktrack solver;
+        BatchStats stats = solveBatch(reader, out, err, solver, pool);
+
+        istringstream output(out.str());
+        string line;
+        int numLines = 0;
+        while (getline(output, line)) {
+            if (numLines >= NUM_PUZZLES || line != lines[puzzles[numLines]]) {
+                cerr << numThreads << " threads: wrong line " << numLines + 1 << ": "
+                     << line << endl;
+                return 1;
+            }
+            ++numLines;
+        }
+        if (numLines != NUM_PUZZLES || stats.numPuzzles != NUM_PUZZLES
+            || stats.numInvalid != (NUM_PUZZLES + 15) / 16) {
+            cerr << numThreads << " threads: " << numLines << " lines, "
+                 << stats.numInvalid << " invalid" << endl;
+            return 1;
+        }
+    }
+
+    cout << "batch test passed" << endl;
+    return 0;
+}